@@ -0,0 +1,56 @@
+#ifndef ADC_INJECT_H
+#define ADC_INJECT_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* On-demand ADC1 conversions through the injected group.
+ *
+ * The regular group keeps streaming (light capture, TIM2 + DMA); an
+ * injected conversion started in software preempts it: the regular
+ * conversion in progress is interrupted, the injected one runs, and the
+ * regular conversion is then restarted (RM0090 13.3.10) -- it is delayed,
+ * not dropped. Latency from request to result with an empty queue is one
+ * injected conversion:
+ *   (sample time + 12) ADC clocks @ 21 MHz, e.g. 480+12 -> ~23.4 µs
+ *   (twice that at the clock_mgr IDLE level, ADC clock 10.5 MHz).
+ *
+ * Effect on the 4 kHz regular stream (1 channel, 3 + 12 clocks, 250 µs
+ * trigger period): requests are chained back to back from the ADC
+ * interrupt, so a full queue (ADC_INJ_QUEUE_LEN - 1 = 3 requests) can
+ * hold the regular sample off for 3 x (23.4 µs + ~2 µs restart) ~= 77 µs
+ * at the longest sample time. That shows up as sample-instant jitter in
+ * one block; no sample is lost. A TIM2 trigger is only ignored -- one
+ * sample lost per 250 µs -- if injected conversions keep the ADC busy for
+ * a whole trigger period, i.e. if callbacks keep re-queueing requests.
+ *
+ * Requests are queued (ADC_INJ_QUEUE_LEN) and served in order. The ADC
+ * interrupt only latches the value and starts the next request; the
+ * callback runs afterwards from PendSV (deferred.c), so it may take a
+ * little longer without holding up the ADC. A request keeps its queue
+ * slot until its callback has run, so every accepted request gets its
+ * callback; if the deferred queue is full the ADC interrupt pends PendSV
+ * and ADC_Inject_Retry() delivers from there instead. */
+
+#define ADC_INJ_QUEUE_LEN   4u
+
+typedef void (*ADC_InjCallback)(uint32_t channel, uint16_t value, void *ctx);
+
+/* Queue a conversion; returns HAL_BUSY when the queue is full. If the ADC
+   refuses to start (ADC_Inject_StartFailures() counts it) the request stays
+   queued and is retried after the next delivery or request. */
+HAL_StatusTypeDef ADC_Inject_Request(uint32_t channel, uint32_t sample_time,
+                                     ADC_InjCallback cb, void *ctx);
+
+/* Convenience: queue and wait (returns HAL_TIMEOUT after timeout_ms).
+   Thread mode with interrupts enabled: sleeps (WFI) until the result. */
+HAL_StatusTypeDef ADC_Inject_Read(uint32_t channel, uint32_t sample_time,
+                                  uint16_t *value, uint32_t timeout_ms);
+
+uint8_t  ADC_Inject_Pending(void);
+uint32_t ADC_Inject_StartFailures(void);
+
+/* PendSV_Handler, after Defer_Run(): delivers results whose post failed. */
+void     ADC_Inject_Retry(void);
+
+#endif /* ADC_INJECT_H */
@@ -0,0 +1,83 @@
+#ifndef BKP_SRAM_H
+#define BKP_SRAM_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Persistent counters and last-fault snapshot in the 4 KB backup SRAM.
+ *
+ * The region survives resets (and power loss while VBAT is present, the
+ * backup regulator is switched on). Counters are plain stores into
+ * BKP_REGION -- no flash writes, no erase cycles. BKP_Init() validates the
+ * layout (magic + size), counts the boot and moves any fault snapshot
+ * into RAM for reporting; BKP_Report() prints everything on the debug
+ * channel.
+ *
+ * The fault snapshot carries a CRC32 (integrity.c, CRC peripheral; the
+ * fault handler takes it over with Integrity_CRC32_Force()); a snapshot
+ * that fails it is reported as corrupt instead of being trusted.
+ *
+ * Faults: HardFault_Handler and Error_Handler fill the snapshot (stacked
+ * registers, fault status registers, a stack excerpt, the zone outputs
+ * that were on) and reset the MCU, so the relays drop instead of staying
+ * energised behind a spinning handler. */
+
+#define BKP_MAGIC          0x424B5031u   /* "BKP1" */
+#define BKP_STACK_WORDS    16u
+
+#define BKP_FAULT_NONE     0u
+#define BKP_FAULT_HARD     1u
+#define BKP_FAULT_ERROR    2u            /* Error_Handler(): pc = caller  */
+
+typedef struct {
+  uint32_t kind;                         /* BKP_FAULT_*                   */
+  uint32_t r0, r1, r2, r3, r12, lr, pc, xpsr;   /* stacked frame          */
+  uint32_t sp, exc_return;
+  uint32_t cfsr, hfsr, mmfar, bfar;
+  uint32_t boot;                         /* boot number it happened in    */
+  uint32_t uptime_s;                     /* seconds into that boot        */
+  uint32_t zones;                        /* RelayZones_Actual() bitmap    */
+  uint32_t stack[BKP_STACK_WORDS];       /* words above the frame         */
+  uint32_t crc;                          /* CRC32 of all fields above     */
+} BKP_Fault;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t size;                         /* sizeof(BKP_Region)            */
+  uint32_t boots;
+  uint32_t reset_csr;                    /* RCC->CSR reset flags, this boot */
+  uint32_t faults;                       /* snapshots taken, cumulative   */
+
+  uint32_t uptime_total_s;               /* all boots                     */
+  uint32_t uptime_boot_s;                /* current boot                  */
+  uint32_t i2c_errors;                   /* failed I2C transactions       */
+
+  /* profiler maxima, DWT cycles, worst ever seen */
+  uint32_t loop_max_cyc;                 /* one main-loop pass (no pacing delay) */
+  uint32_t light_max_cyc;                /* LightCap_Process()            */
+  uint32_t event_lat_max_cyc;            /* event bus publish -> handler  */
+  uint32_t defer_lat_max_cyc;            /* Defer_Post -> PendSV item     */
+
+  BKP_Fault fault;                       /* kind != NONE: not yet reported */
+} BKP_Region;
+
+#define BKP_REGION  ((volatile BKP_Region *)BKPSRAM_BASE)
+
+void BKP_Init(void);                     /* right after SystemClock_Config() */
+void BKP_Report(void);                   /* counters + last fault via printf */
+
+/* Fault snapshot of the previous boot, NULL if it ended cleanly. */
+const BKP_Fault *BKP_LastFault(void);
+uint8_t          BKP_LastFaultValid(void);      /* 1 = CRC matched */
+
+/* Main loop: uptime and profiler maxima, once per second. */
+void BKP_Tick(uint32_t now_ms);
+
+static inline void BKP_Max(volatile uint32_t *slot, uint32_t v){ if (v > *slot) *slot = v; }
+static inline void BKP_CountI2CError(void){ BKP_REGION->i2c_errors++; }
+
+/* Fault entry points; both reset the MCU. */
+void BKP_FaultFromException(uint32_t kind, uint32_t exc_return);
+void BKP_FaultFromError(uint32_t caller_pc);
+
+#endif /* BKP_SRAM_H */
@@ -0,0 +1,53 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Non-blocking tone sequencer for a passive buzzer on TIM12_CH1 / PB14.
+ *
+ * The tone itself is hardware PWM: ARR sets the period, CCR1 the high
+ * time (duty = volume). Buz_Play() turns a note list into ARR/CCR1 pairs
+ * and durations once, up front; a one-shot timebase timer (TIM5
+ * interrupt) then writes the next pair at each note boundary and re-arms
+ * itself for the note after. That is one interrupt per note and none per
+ * tone period. ARR and CCR1 are preloaded, so a note starts at the end of
+ * the tone period in progress, without a runt pulse. Rests keep the
+ * counter running with CCR1 = 0 (pin low); the end of a sequence forces
+ * the output low and stops the counter.
+ *
+ * Sequences carry a priority. A new one replaces the one playing unless
+ * that has a higher priority (an alarm is not cut short by a key click);
+ * looping sequences run until Buz_Stop().
+ *
+ * Call Buz_Play() / Buz_Stop() from the main loop, not from interrupts. */
+
+#define BUZ_TICK_HZ       4200000u   /* TIM12 counter clock (tim.c)         */
+#define BUZ_MAX_STEPS     32u        /* notes per sequence                  */
+#define BUZ_VOL_MAX       8u         /* duty = vol / (2 * BUZ_VOL_MAX), 8 = 50 % */
+
+typedef struct {
+  uint16_t hz;                       /* 0 = rest */
+  uint16_t ms;
+} Buz_Note;
+
+typedef enum {
+  BUZ_PRIO_CLICK = 0,                /* key / encoder feedback */
+  BUZ_PRIO_EVENT,                    /* irrigation start, confirmations */
+  BUZ_PRIO_ALARM                     /* faults */
+} Buz_Prio;
+
+#define BUZ_SEQ(a)        (a), (uint8_t)(sizeof(a) / sizeof((a)[0]))
+
+extern const Buz_Note Buz_Click[1];
+extern const Buz_Note Buz_Irrigate[3];
+extern const Buz_Note Buz_Alarm[4];
+
+void    Buz_Init(TIM_HandleTypeDef *htim);
+/* 1 = started; 0 = a higher-priority sequence is playing (or n == 0) */
+uint8_t Buz_Play(const Buz_Note *seq, uint8_t n, Buz_Prio prio, uint8_t loop);
+void    Buz_Stop(Buz_Prio prio);     /* stops the current sequence if its priority <= prio */
+void    Buz_SetVolume(uint8_t vol);  /* 0 (mute) .. BUZ_VOL_MAX, from the next Buz_Play() */
+uint8_t Buz_Busy(void);
+
+#endif /* BUZZER_H */
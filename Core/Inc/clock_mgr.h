@@ -0,0 +1,74 @@
+#ifndef CLOCK_MGR_H
+#define CLOCK_MGR_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Dynamic HCLK scaling between idle and compute/render bursts.
+ *
+ * Only the AHB/APB prescalers move; the PLL (and the 48 MHz USB clock) keep
+ * running, so a switch costs microseconds and needs no relock. Levels:
+ *
+ *   BOOST  HCLK 168  APB1 42 (tim 84)  APB2 84 (tim 168)   -- boot config
+ *   IDLE   HCLK  42  APB1 42 (tim 42)  APB2 42 (tim  42)
+ *
+ * IDLE divides HCLK by 4 and runs both APB buses undivided, so PCLK1 stays
+ * at 42 MHz while PCLK2 and every timer clock change. After each switch the
+ * dependants are recomputed from the actual clocks: TIM5 (the TB_* and HAL
+ * time base), the SPI1 prescaler (same or slower SCK), TIM2/3/4/12
+ * prescaler or period, the TIM1 I2C slot timing and the bit-bang I2C
+ * delays. Not recomputed: the ADC clock (PCLK2 / 4) is 10.5 MHz at IDLE,
+ * so conversions take twice as long at the same sample counts, and the
+ * TIM8 encoder filter window doubles.
+ *
+ * The dividers are written directly, in an order that never takes an APB
+ * clock above either level's value (HAL_RCC_ClockConfig parks both APB
+ * dividers at /16 on the way). A switch is still not seamless:
+ *   - the timer clocks pass through an intermediate rate for about a
+ *     microsecond and TIM5's prescaler restarts on reload, so the TB_*
+ *     timebase (and HAL_GetTick) falls behind by up to ~3 us per switch.
+ *     The calendar runs from the LSE RTC and does not drift with it;
+ *   - where only the TIM2 / TIM3 prescaler changes, it loads at their next
+ *     update (an immediate UG would fire TRGO), so the 4 kHz ADC trigger
+ *     interval or flow pulse period in progress runs partly at the new
+ *     rate.
+ *
+ * Requests are a bitmask of holders: Clock_Request() boosts at once,
+ * Clock_Release() only drops the hold; the actual drop happens at the
+ * next Clock_IdlePoint() (main loop, before its pacing delay), so a busy
+ * pass switches at most twice. A burst that spans passes (a touch drag
+ * redraws on every one) keeps its own hold until it ends, so it costs
+ * one switch up and one down in total. A switch is postponed while SPI1
+ * or the I2C DMA engine has a transfer in flight. */
+
+typedef enum {
+  CLK_LVL_IDLE = 0,
+  CLK_LVL_BOOST,
+  CLK_LVL_COUNT
+} Clock_Level;
+
+#define CLK_REQ_RENDER   (1u << 0)    /* display drawing          */
+#define CLK_REQ_DSP      (1u << 1)    /* FFT / filtering          */
+#define CLK_REQ_TOUCH    (1u << 2)    /* pen down: held per stroke */
+
+typedef struct {
+  uint8_t  level;                     /* Clock_Level               */
+  uint32_t hclk_hz;
+  uint32_t transitions;
+  uint32_t postponed;                 /* peripheral busy at switch time */
+  uint32_t cost_last_us;              /* one switch incl. recompute */
+  uint32_t cost_max_us;
+  uint32_t res_ms[CLK_LVL_COUNT];     /* residency since Clock_Init */
+} Clock_Stats;
+
+/* After all peripherals are initialised; starts at BOOST. */
+void        Clock_Init(void);
+
+void        Clock_Request(uint32_t who);
+void        Clock_Release(uint32_t who);
+void        Clock_IdlePoint(void);
+
+Clock_Level Clock_Current(void);
+void        Clock_GetStats(Clock_Stats *out);
+
+#endif /* CLOCK_MGR_H */
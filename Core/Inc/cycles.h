@@ -0,0 +1,15 @@
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include "main.h"
+
+/* DWT cycle counter, used for latency stamps and cycle budgets. Every
+ * module that reads DWT->CYCCNT calls Cycles_Enable() from its init; the
+ * counter is never reset, so concurrent users only ever take wrap-safe
+ * differences. */
+static inline void Cycles_Enable(void){
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#endif /* CYCLES_H */
@@ -0,0 +1,40 @@
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Deferred procedure calls (interrupt bottom halves) run from PendSV.
+ *
+ * An ISR does only the register work that cannot wait, then posts the
+ * rest with Defer_Post(fn, arg). PendSV runs at the lowest priority, so
+ * every real interrupt preempts it, but it still runs as soon as the
+ * posting ISR (and any nested ones) return -- ahead of the main loop and
+ * without waiting out its LOOP_PERIOD_MS delay.
+ *
+ * Posting is lock-free (LDREX/STREX claim + per-slot sequence, the ring in
+ * mpsc_ring.c shared with event_bus.c) and safe from any priority. Items run in post order;
+ * they must not block and must not touch the SPI1 display bus. */
+
+#define DEFER_QUEUE_DEPTH   16u    /* power of two */
+
+typedef void (*DeferFn)(void *arg);
+
+typedef struct {
+  uint32_t posted;
+  uint32_t dropped;        /* queue full: the ISR must fall back          */
+  uint32_t ran;
+  uint32_t lat_max;        /* cycles, post -> start of the item           */
+} Defer_Stats;
+
+void    Defer_Init(void);                 /* PendSV priority = lowest */
+
+/* Any context; 0 when the queue is full (item not queued). */
+uint8_t Defer_Post(DeferFn fn, void *arg);
+
+/* PendSV_Handler body. */
+void    Defer_Run(void);
+
+void    Defer_GetStats(Defer_Stats *out);
+
+#endif /* DEFERRED_H */
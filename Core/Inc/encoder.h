@@ -0,0 +1,29 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Rotary encoder on TIM8 (encoder mode TI12, PC6/PC7) + push button on
+ * EXTI (ENC_SW_Pin, active low).
+ *
+ * The timer counts every quadrature edge in hardware -- no interrupt and
+ * no CPU per detent. Enc_Read() takes the count difference since the last
+ * call, keeps the sub-detent remainder, and scales whole detents by the
+ * turning speed (ENC_ACCEL_* table) so large changes need few turns.
+ *
+ * The button is debounced with a TIM5 timebase timer: each falling edge
+ * (re)starts an ENC_DEBOUNCE_US window, and when the window runs out
+ * without another edge the pin is sampled once; low counts a press.
+ * Release bounce keeps restarting the window and ends high, so it never
+ * counts. Enc_Clicked() consumes one press. This file owns
+ * HAL_GPIO_EXTI_Callback(). */
+
+#define ENC_COUNTS_PER_DETENT   4     /* one full quadrature cycle per click */
+#define ENC_DEBOUNCE_US         30000u
+
+void    Enc_Init(TIM_HandleTypeDef *htim);
+int32_t Enc_Read(uint32_t now_ms);    /* accelerated detents since last call */
+uint8_t Enc_Clicked(void);            /* 1 per debounced press             */
+
+#endif /* ENCODER_H */
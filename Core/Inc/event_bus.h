@@ -0,0 +1,67 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Typed publish/subscribe bus between interrupt handlers and the main loop.
+ *
+ * Publish: any context (ISR or main). Slots are claimed with LDREX/STREX on
+ * the queue head and released with a per-slot sequence number, so several
+ * ISR priorities may publish concurrently without masking interrupts (MPSC).
+ * A full queue drops the event and counts it; publish never blocks.
+ *
+ * Dispatch: main context only. EventBus_Dispatch() drains the queue and
+ * calls every subscriber registered for the event type, in registration
+ * order: O(subscribers of that type), no allocation.
+ *
+ * Latency: each event carries the DWT cycle count of its publish; the bus
+ * keeps last/worst publish -> handler latency in cycles. */
+
+#define EB_QUEUE_DEPTH      16u    /* power of two                          */
+#define EB_MAX_SUBS         4u     /* per event type                        */
+
+typedef enum {
+  EVT_LIGHT_BLOCK = 0,     /* ADC1 half-buffer ready      (ISR)  u = half  */
+  EVT_SOIL_BLOCK,          /* ADC2 half-buffer ready      (ISR)  u = half  */
+  EVT_RTC_ALARM,           /* RTC alarm A matched         (ISR)  u = count */
+  EVT_RTC_WAKEUP,          /* RTC wakeup timer elapsed    (ISR)  u = count */
+  EVT_COUNT
+} EventType;
+
+typedef struct {
+  uint8_t  type;           /* EventType                                     */
+  uint8_t  rsv[3];
+  uint32_t t_cyc;          /* DWT->CYCCNT at publish                        */
+  union {
+    uint32_t u;
+    int32_t  i;
+    float    f;
+    struct { uint16_t x, y; } pt;
+  } v;
+} Event;
+
+typedef void (*EventHandler)(const Event *ev, void *ctx);
+
+typedef struct {
+  uint32_t published;
+  uint32_t dropped;        /* queue full                                    */
+  uint32_t dispatched;
+  uint32_t lat_last;       /* cycles, publish -> handler entry              */
+  uint32_t lat_max;
+} EventBus_Stats;
+
+void    EventBus_Init(void);
+
+/* Main context, normally at boot; 0 if the type's table is full. */
+uint8_t EventBus_Subscribe(EventType type, EventHandler fn, void *ctx);
+
+/* Any context; 0 if the queue was full (event dropped). */
+uint8_t EventBus_Publish(EventType type, uint32_t value);
+
+/* Main context; returns the number of events handled. */
+uint16_t EventBus_Dispatch(void);
+
+void    EventBus_GetStats(EventBus_Stats *out);
+
+#endif /* EVENT_BUS_H */
@@ -0,0 +1,32 @@
+#ifndef FFT_Q15_H
+#define FFT_Q15_H
+
+#include <stdint.h>
+
+/* Fixed-point real FFT (q15), radix-2, for power-of-two sizes up to
+ * FFT_Q15_MAX_N. Pure C (no HAL, no CMSIS-DSP in this tree).
+ *
+ * A real N-point block is packed into N/2 complex points, transformed
+ * with a radix-2 DIT complex FFT that scales by 1/2 per stage (no
+ * overflow), then split into the N/2 positive-frequency bins.
+ * Output scale: a full-scale sine of amplitude A at bin k gives |X[k]| ~= A,
+ * i.e. bins are amplitudes, not sums. */
+
+#define FFT_Q15_MAX_N   512u
+
+typedef struct { int16_t re, im; } cq15_t;
+
+/* Build twiddle/bit-reverse tables for size n (call once; uses sinf at init only). */
+int  FFT_Q15_Init(uint16_t n);
+
+/* in:  n real q15 samples packed as n/2 complex points, x[2i] in .re and
+ *      x[2i+1] in .im (destroyed; used as work area)
+ * out: n/2 complex bins, k = 0..n/2-1 (bin k = k*fs/n Hz) */
+void FFT_Q15_Real(cq15_t *in, cq15_t *out);
+
+/* |X|^2 of one bin (q30) */
+static inline uint32_t FFT_Q15_Mag2(cq15_t c){
+  return (uint32_t)((int32_t)c.re * c.re) + (uint32_t)((int32_t)c.im * c.im);
+}
+
+#endif /* FFT_Q15_H */
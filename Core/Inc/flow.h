@@ -0,0 +1,47 @@
+#ifndef FLOW_H
+#define FLOW_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Hall-effect flow meter on PB4 (TIM3_CH1), counted entirely in hardware.
+ *
+ *   TIM3: 10 µs time base, slave reset on each rising pulse -> CCR1 holds
+ *         the last pulse period, CNT the time since the last pulse.
+ *   TIM9: clocked by TIM3 TRGO (the same reset) -> CNT counts pulses.
+ *
+ * No interrupt per pulse. Flow_Process() reads both counters, extends the
+ * 16-bit pulse count to 32 bits (call at least once per 65536 pulses),
+ * converts the period to L/min and checks for leaks and blocked lines
+ * against the zone demand it is given. */
+
+#define FLOW_PULSES_PER_L     450u     /* YF-S201: F[Hz] = 7.5 * Q[L/min]   */
+#define FLOW_TICK_HZ          100000u  /* TIM3 counter clock                */
+
+/* Fault detection */
+#define FLOW_SETTLE_MS        3000u    /* after a demand change: fill / drain time    */
+#define FLOW_MIN_LPM_X10      5u       /* demand on, less than this -> blocked line   */
+#define FLOW_LEAK_ML          200u     /* volume with no demand after settle -> leak  */
+
+#define FLOW_ST_FLOWING       0x01u
+#define FLOW_ST_LEAK          0x02u
+#define FLOW_ST_BLOCKED       0x04u
+
+typedef struct {
+  uint32_t pulses;          /* since Flow_Start                         */
+  uint32_t volume_ml;       /* cumulative                               */
+  uint16_t lpm_x10;         /* instantaneous, 0.1 L/min (from period)   */
+  uint16_t period_ticks;    /* last pulse period, 10 µs                 */
+  uint32_t leak_ml;         /* volume seen while no zone demanded water */
+  uint8_t  status;          /* FLOW_ST_*                                */
+} Flow_Result;
+
+HAL_StatusTypeDef Flow_Start(void);
+
+/* demand = bitmap of zones currently open (0 = nothing should flow). */
+void Flow_Process(uint32_t now_ms, uint8_t demand);
+
+void Flow_Get(Flow_Result *out);
+void Flow_ClearFaults(void);
+
+#endif /* FLOW_H */
@@ -0,0 +1,39 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+
+/* Min/max history for the chart screen, as a downsampling pyramid.
+ *
+ * Level 0 keeps HIST_DEPTH base buckets of HIST_BASE_MIN minutes each
+ * (68 h), fed from the closed minute buckets of sensor_stats. Level k
+ * halves the resolution of level k-1: each bucket is the min/max of its
+ * two children and is kept in a ring of HIST_DEPTH >> k slots. All levels
+ * up to HIST_LEVELS - 1 (the widest zoom of the chart, 8 base buckets
+ * per column) are updated when a base bucket closes (two reads per level), so a chart
+ * column is one lookup at the level whose bucket matches the column
+ * width, however long the history is.
+ *
+ * Buckets are addressed by absolute index at their level, index = base
+ * sequence number >> level; base sequence 0 is the first bucket since
+ * Hist_Init(). Values are stored as 8-bit codes (0.5 unit steps). */
+
+#define HIST_BASE_MIN   2u
+#define HIST_DEPTH      2048u          /* base buckets, power of two      */
+#define HIST_LEVELS     4u             /* 1..8 base buckets per bucket    */
+
+typedef enum {
+  HIST_CH_TEMP = 0,                    /* deg C, -20 .. +107 */
+  HIST_CH_LIGHT,                       /* %,      0 .. 100   */
+  HIST_CH_COUNT
+} Hist_Channel;
+
+void     Hist_Init(void);
+void     Hist_AddMinute(Hist_Channel ch, float lo, float hi);  /* one closed minute */
+uint8_t  Hist_EndMinute(void);         /* 1 when this closed a base bucket */
+uint32_t Hist_Count(void);             /* base buckets closed so far       */
+
+/* Min/max of bucket idx at level; 0 if out of the ring or empty. */
+uint8_t  Hist_Range(Hist_Channel ch, uint8_t level, uint32_t idx, float *lo, float *hi);
+
+#endif /* HISTORY_H */
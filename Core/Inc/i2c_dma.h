@@ -0,0 +1,42 @@
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Timer+DMA I²C engine on the same PB6=SCL / PB7=SDA open-drain pins as
+ * i2c_sw.c. A transaction is compiled into quarter-bit "slots": TIM1 UP
+ * moves one BSRR word per slot into GPIOB->BSRR (DMA2 S5), TIM1 CC1
+ * samples GPIOB->IDR late in every slot (DMA2 S1). Bytes and ACKs are
+ * decoded from the IDR buffer when the transfer ends.
+ *
+ * Fast mode only (~400 kHz, tLOW/tHIGH = 2 slots each). No clock
+ * stretching: use it for devices that never stretch (LM75 etc.). */
+
+#define I2C_DMA_ENABLE      1       /* 0 = LM75 zones use the bit-bang driver */
+
+#define I2CDMA_SLOT_NS      650u    /* 4 slots per bit -> 2.6 µs -> ~385 kHz */
+#define I2CDMA_MAX_SLOTS    512u    /* 12 bytes on the wire (Mem_Read <= 9 data bytes) */
+
+/* Recompute slot timing from the TIM1 clock (after MX_TIM1_Init / clock change) */
+void I2CDMA_Init(void);
+
+/* Blocking calls (CPU sleeps in WFI while the waveform plays). Main loop
+ * only, like the bit-bang driver on the same pins -- one transaction at a
+ * time, so the two never drive PB6/PB7 together. HAL_TIMEOUT when the
+ * waveform has not finished after twice its length (TIM1 or DMA stalled):
+ * the engine is stopped and the pins are released. */
+HAL_StatusTypeDef I2CDMA_Mem_Read (uint8_t addr8, uint8_t mem, uint8_t *data, uint16_t len);
+HAL_StatusTypeDef I2CDMA_Mem_Write(uint8_t addr8, uint8_t mem, const uint8_t *data, uint16_t len);
+HAL_StatusTypeDef I2CDMA_Read     (uint8_t addr8, uint8_t *data, uint16_t len); /* current pointer */
+
+/* 1 while a waveform is playing (TIM1 running) */
+uint8_t I2CDMA_Busy(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* I2C_DMA_H */
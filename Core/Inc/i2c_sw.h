@@ -11,9 +11,25 @@ extern "C" {
 void SWI2C_Init_PB6_PB7(void);
 void SWI2C_BusClear(void);
 
+/* Speed profiles, chosen per device and applied per transaction.
+ * Real SCL is a bit slower than nominal (GPIO call overhead, rise time of
+ * the pull-ups); FM+ needs strong pull-ups (~1k) to be meaningful. */
+typedef enum {
+  SWI2C_STD = 0,    /* 100 kHz (default for every address) */
+  SWI2C_FAST,       /* 400 kHz */
+  SWI2C_FMP,        /* 1 MHz fast-mode plus */
+  SWI2C_SPEED_COUNT
+} SWI2C_Speed;
+
+void SWI2C_SetDeviceSpeed(uint8_t addr7, SWI2C_Speed sp);
+
+/* Rebuild cycle counts from SystemCoreClock (done in init; call again after a clock change) */
+void SWI2C_RecalcTiming(void);
+
 /* 8-bit address API (7-bit<<1) — compatible with HAL-style addr8 */
 HAL_StatusTypeDef SWI2C_Mem_Read (uint8_t addr8, uint8_t mem, uint8_t *data, uint16_t len);
 HAL_StatusTypeDef SWI2C_Mem_Write(uint8_t addr8, uint8_t mem, const uint8_t *data, uint16_t len);
+HAL_StatusTypeDef SWI2C_Read     (uint8_t addr8, uint8_t *data, uint16_t len); /* current pointer */
 
 /* Scanner: probe a single 7-bit address; returns 1 on ACK */
 uint8_t SWI2C_Scan_One(uint8_t addr7);
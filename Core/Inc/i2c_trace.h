@@ -0,0 +1,56 @@
+#ifndef I2C_TRACE_H
+#define I2C_TRACE_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Always-on trace of software I2C transactions (i2c_sw.c) in a fixed RAM
+ * ring. One entry per SWI2C_* call; timestamps are raw DWT->CYCCNT.
+ *
+ * Dump format (after a '#' header line):
+ *   n,op,addr,reg,len,speed,t_start,cycles,ack_mask,nbytes,stretch,flags
+ * ack_mask bit i = i-th byte written by the master (address bytes
+ * included) was ACKed; nbytes says how many bits are meaningful.
+ * A closing "# crc32=XXXXXXXX" line holds the CRC32 (integrity.c, CRC
+ * peripheral) over every byte between the '#' lines, so truncated SWO
+ * captures show. */
+
+#define I2C_TRACE_ENABLE   1
+#define I2C_TRACE_DEPTH    32u      /* entries, power of two (24 B each) */
+
+typedef enum {
+  I2CT_MEM_READ = 0,
+  I2CT_MEM_WRITE,
+  I2CT_READ,
+  I2CT_SCAN
+} I2CTraceOp;
+
+#define I2CT_F_FAIL        0x01u    /* call returned != HAL_OK / no ACK */
+#define I2CT_F_STRETCH_TO  0x02u    /* SCL held low past the timeout    */
+
+typedef struct {
+  uint32_t t_start;      /* CYCCNT at START        */
+  uint32_t t_end;        /* CYCCNT after STOP      */
+  uint32_t ack_mask;
+  uint32_t stretch_cyc;  /* total cycles SCL was held low by the slave */
+  uint16_t len;          /* data bytes requested   */
+  uint8_t  op;           /* I2CTraceOp             */
+  uint8_t  addr7;
+  uint8_t  reg;          /* 0 for READ/SCAN        */
+  uint8_t  nbytes;       /* bytes written (<= 32 tracked) */
+  uint8_t  flags;
+  uint8_t  speed;        /* SWI2C_Speed used       */
+} I2CTrace_Entry;
+
+/* Called by i2c_sw.c around each transaction */
+I2CTrace_Entry *I2CTrace_Begin(uint8_t op, uint8_t addr7, uint8_t reg, uint16_t len, uint8_t speed);
+void            I2CTrace_End(I2CTrace_Entry *e, uint8_t ok);
+
+uint32_t              I2CTrace_Total(void);        /* entries ever recorded */
+uint32_t              I2CTrace_Failures(void);
+const I2CTrace_Entry *I2CTrace_Recent(uint16_t back); /* 0 = newest, NULL if none */
+
+/* Print the ring oldest-first via printf (blocking, debug use only). */
+void I2CTrace_Dump(void);
+
+#endif /* I2C_TRACE_H */
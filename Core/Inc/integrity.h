@@ -0,0 +1,66 @@
+#ifndef INTEGRITY_H
+#define INTEGRITY_H
+
+#include "main.h"
+#include "integrity_ref.h"
+#include <stdint.h>
+
+/* Checksums for persisted records and telemetry frames.
+ *
+ * CRC32 runs on the CRC peripheral with the definition given in
+ * integrity_ref.h; Integrity_CRC32_SW() there is the table-driven
+ * reference that produces identical results. It is used when the
+ * peripheral is claimed by someone else (a DMA job, an interrupted
+ * caller) and by Integrity_SelfTest() / the host tests.
+ *
+ * The peripheral is claimed atomically (LDREX/STREX) by every user, so
+ * Integrity_CRC32() is safe from any context: a caller that finds it
+ * taken falls back to the software path instead of waiting.
+ *
+ * Large blocks can be fed by DMA2 Stream6 (memory -> CRC->DR) while the
+ * CPU does other work: Integrity_CRC32_Start() / _Busy() / _Result(). The
+ * job keeps the peripheral until _Result() has read it.
+ *
+ * Text streams (trace dumps) go through Integrity_Stream: bytes are
+ * packed into words and fed to the peripheral as they come; the result
+ * equals Integrity_CRC32() over the concatenated bytes. */
+
+#define INTEGRITY_DMA_MIN      256u     /* bytes; shorter blocks are CPU-fed */
+
+void     Integrity_Init(void);
+
+/* Blocking. Hardware when free, otherwise the software reference. */
+uint32_t Integrity_CRC32(const void *data, uint32_t len);
+
+/* Fault handlers only (interrupts masked, reset follows): takes the
+   peripheral from whoever holds it, aborting a DMA job. */
+uint32_t Integrity_CRC32_Force(const void *data, uint32_t len);
+
+/* Asynchronous DMA feed (word-aligned data, len >= INTEGRITY_DMA_MIN).
+   Every successful Start must be followed by Result. */
+HAL_StatusTypeDef Integrity_CRC32_Start(const void *data, uint32_t len);
+uint8_t  Integrity_CRC32_Busy(void);
+uint32_t Integrity_CRC32_Result(void);          /* waits if still busy, then frees the unit */
+
+typedef struct {
+  uint32_t crc;            /* software path state                      */
+  uint32_t word;           /* bytes not yet fed, little-endian          */
+  uint8_t  n;              /* valid bytes in word                       */
+  uint8_t  hw;             /* 1 = holds the peripheral                  */
+} Integrity_Stream;
+
+void     Integrity_StreamBegin(Integrity_Stream *s);
+void     Integrity_StreamFeed(Integrity_Stream *s, const void *data, uint32_t len);
+uint32_t Integrity_StreamEnd(Integrity_Stream *s);     /* frees the unit */
+
+/* Throughput in bytes per 1000 cycles, from the last self-test. */
+typedef struct {
+  uint32_t bytes;
+  uint32_t hw_bpkc, dma_bpkc, sw_bpkc;
+} Integrity_Bench;
+
+/* HW, DMA and SW over a test pattern must agree; fills the benchmark.
+   Returns 1 on success. Reported on the debug channel. */
+uint8_t  Integrity_SelfTest(Integrity_Bench *out);
+
+#endif /* INTEGRITY_H */
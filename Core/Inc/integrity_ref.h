@@ -0,0 +1,27 @@
+#ifndef INTEGRITY_REF_H
+#define INTEGRITY_REF_H
+
+#include <stdint.h>
+
+/* Software CRC reference for integrity.c (no HAL, builds on the host too).
+ *
+ * CRC32 has the CRC peripheral's definition (poly 0x04C11DB7, init
+ * 0xFFFFFFFF, no reflection, no final XOR, fed in 32-bit words): whole
+ * words as they sit in memory (little-endian uint32, bit 31 first), then
+ * the 0..3 trailing bytes byte-wise, MSB first. Over a byte string that is
+ * CRC-32/MPEG-2 of the string with every whole 4-byte group reversed.
+ *
+ * CRC16 is CRC-16/CCITT-FALSE (0x1021, init 0xFFFF). */
+
+#define INTEGRITY_CRC32_INIT   0xFFFFFFFFu
+#define INTEGRITY_CRC16_INIT   0xFFFFu
+
+void     Integrity_RefInit(void);               /* table build; optional, else on first use */
+
+/* crc = INTEGRITY_CRC32_INIT to start, or a previous result to continue
+   (the previous length must have been a multiple of 4). */
+uint32_t Integrity_CRC32_SW(uint32_t crc, const void *data, uint32_t len);
+
+uint16_t Integrity_CRC16(uint16_t crc, const void *data, uint32_t len);
+
+#endif /* INTEGRITY_REF_H */
@@ -0,0 +1,56 @@
+#ifndef LIGHT_CAPTURE_H
+#define LIGHT_CAPTURE_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* High-rate light capture on PC0 / ADC1 IN10.
+ * TIM2 TRGO triggers ADC1 at LIGHT_FS_HZ; DMA2 Stream4 fills a circular
+ * buffer of 2 x LIGHT_N samples (ping-pong). Each finished half is handed
+ * to LightCap_Process() from the main loop, which windows it, runs a
+ * q15 real FFT and publishes DC level, percent flicker and the dominant
+ * AC frequency. The DMA keeps filling the other half meanwhile.
+ *
+ * Cycle budget per block (168 MHz, -O2, N=512):
+ *   copy + DC + Hann window   ~  6 k cycles
+ *   256-pt complex FFT + split ~ 45 k cycles
+ *   peak search (no sqrt)     ~  3 k cycles
+ *   total                     ~ 55 k cycles = ~0.33 ms per 128 ms block (<0.3 % CPU)
+ * Measured values are kept in LightCap_Result.cycles / cycles_max.
+ * The hard deadline is one half-buffer (LIGHT_N / LIGHT_FS_HZ = 128 ms)
+ * from the DMA callback until the copy pass has finished; a late copy is
+ * detected and the block dropped (LightCap_Result.overruns). */
+
+#define LIGHT_FS_HZ        4000u     /* TIM2: 84 MHz / 21000 */
+#define LIGHT_N            512u      /* block length -> 7.8125 Hz bins */
+
+/* Artificial light: dominant line within ±LIGHT_MAINS_TOL_HZ of 100 or
+ * 120 Hz and percent flicker above LIGHT_FLICKER_MIN_PCT. */
+#define LIGHT_MAINS_TOL_HZ     6u
+#define LIGHT_FLICKER_MIN_PCT  3u
+
+typedef struct {
+  uint16_t dc_raw;          /* mean ADC counts (0..4095)                 */
+  uint8_t  flicker_pct;     /* (max-min)/(max+min) * 100 over the block  */
+  uint16_t peak_hz_x10;     /* dominant AC frequency, 0.1 Hz (interpolated) */
+  uint16_t peak_amp;        /* its amplitude in ADC counts               */
+  uint8_t  artificial;      /* 1 = mains-driven flicker detected         */
+  uint32_t blocks;          /* processed blocks                          */
+  uint32_t overruns;        /* blocks dropped (main loop too late), filled by LightCap_Get() */
+  uint32_t cycles, cycles_max; /* DWT cycles of last / worst Process()   */
+} LightCap_Result;
+
+HAL_StatusTypeDef LightCap_Start(void);   /* TIM2 + ADC1 DMA */
+void              LightCap_Stop(void);
+uint8_t           LightCap_Running(void);
+
+/* Call from the main loop; returns 1 when a new result was published. */
+uint8_t LightCap_Process(void);
+
+/* Latest result; 0 until the first block is done. */
+uint8_t LightCap_Get(LightCap_Result *out);
+
+/* ADC1 DMA half (0) / full (1) event, called from adc.c */
+void    LightCap_OnDma(uint8_t half);
+
+#endif /* LIGHT_CAPTURE_H */
@@ -71,6 +71,9 @@ void Error_Handler(void);
 #define Relay_GPIO_Port GPIOB
 #define test_LED_Pin GPIO_PIN_13
 #define test_LED_GPIO_Port GPIOB
+#define ENC_SW_Pin GPIO_PIN_8
+#define ENC_SW_GPIO_Port GPIOC
+#define ENC_SW_EXTI_IRQn EXTI9_5_IRQn
 
 /* USER CODE BEGIN Private defines */
 
@@ -0,0 +1,49 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Bounded lock-free multi-producer / single-consumer ring index
+ * (Vyukov's per-slot sequence scheme), shared by event_bus.c and
+ * deferred.c. The ring only hands out positions; each user keeps its own
+ * payload array of the same power-of-two depth, indexed by MPSC_Slot().
+ *
+ *   slot seq == pos      free for the producer of pos
+ *   slot seq == pos + 1  filled, ready for the consumer
+ *
+ * Producers (any context, any priority) claim a position with LDREX/STREX
+ * on the head -- an exception between the two clears the monitor, so a
+ * preempting producer just makes the other retry; no interrupt masking.
+ * After writing the payload they MPSC_Commit() it. The single consumer
+ * MPSC_Peek()s the tail, copies the payload out and MPSC_Release()s it. */
+
+typedef struct {
+  volatile uint32_t *seq;        /* depth entries, owned by the user    */
+  uint32_t           mask;       /* depth - 1                           */
+  volatile uint32_t  head;       /* next claim position (producers)     */
+  uint32_t           tail;       /* next consume position (consumer)    */
+} MPSC_Ring;
+
+/* depth must be a power of two; seq points to depth words. */
+void    MPSC_Init(MPSC_Ring *r, volatile uint32_t *seq, uint32_t depth);
+
+/* Producer: 1 and *pos claimed, 0 when the ring is full. */
+uint8_t MPSC_Claim(MPSC_Ring *r, uint32_t *pos);
+/* Producer: payload at MPSC_Slot(r, pos) is written, hand it over. */
+void    MPSC_Commit(MPSC_Ring *r, uint32_t pos);
+
+/* Consumer: 1 and *pos when the tail slot is filled, 0 when empty or
+ * its producer is still writing. */
+uint8_t MPSC_Peek(MPSC_Ring *r, uint32_t *pos);
+/* Consumer: payload copied out, give the tail slot back one lap ahead. */
+void    MPSC_Release(MPSC_Ring *r);
+
+static inline uint32_t MPSC_Slot(const MPSC_Ring *r, uint32_t pos){ return pos & r->mask; }
+
+/* Lock-free counter increment, safe from any priority. */
+static inline void MPSC_AtomicInc(volatile uint32_t *p){
+  do { } while (__STREXW(__LDREXW(p) + 1u, p));
+}
+
+#endif /* MPSC_RING_H */
@@ -0,0 +1,41 @@
+#ifndef RELAY_ZONES_H
+#define RELAY_ZONES_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Relay / valve zone outputs on GPIOB.
+ *
+ * All zone pins sit on one port, so a whole zone bitmap goes out in a
+ * single BSRR write: every pin that changes does so on the same bus cycle,
+ * with no read-modify-write window for an interrupt to corrupt.
+ *
+ * Inrush sequencing: turn-offs always apply at once. Zones in
+ * RZ_INRUSH_MASK (pumps, solenoids) are energised one at a time, at least
+ * RZ_STAGGER_MS apart, so their inrush currents never add up. Zones in
+ * RZ_PUMP_MASK go last, after every valve they feed is already open.
+ * RelayZones_Service() from the main loop releases the queued turn-ons. */
+
+#define RZ_COUNT          4u
+#define RZ_PORT           GPIOB
+#define RZ_PINS           { GPIO_PIN_12, GPIO_PIN_5, GPIO_PIN_15, GPIO_PIN_9 }
+#define RZ_ACTIVE_LOW     0x00u    /* zone bits driven low = on (relay boards)   */
+#define RZ_INRUSH_MASK    0x0Fu    /* zones that must not switch on together     */
+#define RZ_PUMP_MASK      0x00u    /* zones switched on only after all valves    */
+#define RZ_STAGGER_MS     250u
+
+void    RelayZones_Init(void);                  /* pins as outputs, all zones off */
+
+/* Request a full zone bitmap (bit i = zone i). Offs and the first allowed
+   on go out in one port write; further ons are released by Service(). */
+void    RelayZones_Set(uint8_t mask);
+void    RelayZones_SetZone(uint8_t zone, uint8_t on);
+
+/* Call from the main loop; returns the bitmap currently driven. */
+uint8_t RelayZones_Service(uint32_t now_ms);
+
+uint8_t RelayZones_Target(void);
+uint8_t RelayZones_Actual(void);
+uint8_t RelayZones_Busy(void);                  /* 1 = turn-ons still queued */
+
+#endif /* RELAY_ZONES_H */
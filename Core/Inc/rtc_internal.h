@@ -0,0 +1,77 @@
+#ifndef RTC_INTERNAL_H
+#define RTC_INTERNAL_H
+
+#include "main.h"
+#include "rtc_ds1307.h"
+#include <stdint.h>
+
+/* On-chip RTC as the primary calendar.
+ *
+ * Clocked from LSE (32.768 kHz), LSI as a fallback if the crystal does not
+ * start. Reading the time is two register loads from the shadow registers
+ * -- no I2C traffic. The calendar lives in the backup domain, so it keeps
+ * running through resets (and on VBAT); RTCInt_Init() only seeds it from
+ * the DS1307 when it was not running yet.
+ *
+ * The DS1307 becomes the reference: read at boot and every
+ * RTCINT_SYNC_PERIOD_MS by RTCInt_Service(); a difference of more than
+ * RTCINT_SYNC_TOL_S re-seeds the on-chip calendar. The measured drift is
+ * kept in the stats.
+ *
+ * Alarm A (daily, hh:mm:ss) and the wakeup timer (1..65536 s on the 1 Hz
+ * ck_spre) raise EVT_RTC_ALARM / EVT_RTC_WAKEUP on the event bus. Both go
+ * through EXTI (lines 17 / 22, rising edge), so they also wake the core
+ * from Stop mode.
+ *
+ * Register-level driver: HAL_RTC_MODULE_ENABLED stays off. */
+
+#define RTCINT_LSE_TIMEOUT_MS   2000u          /* LSE start-up budget        */
+#define RTCINT_SYNC_PERIOD_MS   3600000u       /* DS1307 cross-check, 1 h    */
+#define RTCINT_SYNC_TOL_S       2              /* re-seed above this drift   */
+
+#define RTCINT_SRC_NONE         0u
+#define RTCINT_SRC_LSE          1u
+#define RTCINT_SRC_LSI          2u
+
+typedef struct {
+  uint32_t syncs;          /* DS1307 cross-checks done                      */
+  uint32_t sync_errors;    /* DS1307 read failed                            */
+  uint32_t corrections;    /* times the calendar was re-seeded              */
+  int32_t  drift_last_s;   /* DS1307 - RTC at the last cross-check          */
+  int32_t  drift_ppm;      /* estimate over the last sync interval          */
+  uint32_t alarms;
+  uint32_t wakeups;
+} RTCInt_Stats;
+
+/* After BKP_Init() (backup domain access) and before the event bus users. */
+void    RTCInt_Init(void);
+uint8_t RTCInt_Source(void);                    /* RTCINT_SRC_*            */
+
+/* Shadow-register read; valid once the calendar has been seeded. */
+void    RTCInt_GetTime(DS1307_Time *t);
+HAL_StatusTypeDef RTCInt_SetTime(const DS1307_Time *t);
+
+/* Calendar date as RTC->DR holds it without the weekday (BCD 0x00YYMxDD,
+   month in bits 12:8). Compare for equality only; changes at midnight. */
+uint32_t RTCInt_GetDate(void);
+
+/* Setup commit: on-chip calendar and DS1307 together. */
+HAL_StatusTypeDef RTCInt_SetTimeBoth(const DS1307_Time *t);
+
+/* Main loop: periodic DS1307 drift cross-check. */
+void    RTCInt_Service(uint32_t now_ms);
+
+/* Daily alarm A at hh:mm:ss; Clear disables it. */
+void    RTCInt_SetAlarm(uint8_t h, uint8_t m, uint8_t s);
+void    RTCInt_ClearAlarm(void);
+
+/* Periodic wakeup every `seconds` (1..65536); 0 stops it. */
+void    RTCInt_SetWakeup(uint32_t seconds);
+
+void    RTCInt_GetStats(RTCInt_Stats *out);
+
+/* IRQ entry points (stm32f4xx_it.c). */
+void    RTCInt_AlarmIRQ(void);
+void    RTCInt_WakeupIRQ(void);
+
+#endif /* RTC_INTERNAL_H */
@@ -0,0 +1,80 @@
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include "rtc_ds1307.h"
+#include <stdint.h>
+
+/* Streaming statistics with wall-clock rollups.
+ *
+ * Every sample is folded (Welford) into the open minute, hour and day
+ * accumulators of its channel and into two exponential averages -- O(1)
+ * per sample, no sample is stored. Buckets close on the RTC's minute and
+ * hour boundaries and when its date (RTC->DR) changes, into fixed rings:
+ *
+ *   minute ring  STATS_MINUTES   (last hour by minute)
+ *   hour ring    STATS_HOURS     (last two days by hour)
+ *   day ring     STATS_DAYS      (last month by day)
+ *
+ * Stats_Window() merges the open bucket and the newest closed ones (Chan's
+ * parallel formula), so "mean light over the last 6 hours" costs six
+ * merges whatever the sample rate. Buckets without samples still take
+ * their slot, so a window always spans wall-clock time.
+ *
+ * RAM only; contents start over at reset. */
+
+#define STATS_MINUTES    60u
+#define STATS_HOURS      48u
+#define STATS_DAYS       31u
+
+typedef enum {
+  STAT_CH_TEMP = 0,        /* zone 0 temperature, deg C */
+  STAT_CH_LIGHT,           /* light level, %            */
+  STAT_CH_SOIL,            /* mean VWC of live probes, % */
+  STAT_CH_FLOW,            /* flow rate, L/min          */
+  STAT_CH_COUNT
+} Stat_Channel;
+
+typedef enum {
+  STAT_MINUTE = 0,
+  STAT_HOUR,
+  STAT_DAY,
+  STAT_LEVEL_COUNT
+} Stat_Level;
+
+typedef struct {
+  uint32_t n;
+  float    mean;
+  float    m2;             /* sum of squared deviations from the mean */
+  float    min, max;
+} Stat_Acc;
+
+typedef struct {
+  uint32_t n;
+  float    mean;
+  float    stddev;         /* sample standard deviation (n-1) */
+  float    min, max;
+} Stat_Summary;
+
+/* Accumulator primitives (usable on their own) */
+void    StatAcc_Reset(Stat_Acc *a);
+void    StatAcc_Add  (Stat_Acc *a, float x);
+void    StatAcc_Merge(Stat_Acc *a, const Stat_Acc *b);
+void    StatAcc_Summary(const Stat_Acc *a, Stat_Summary *out);
+
+void    Stats_Init(void);
+void    Stats_Add(Stat_Channel ch, float x);
+/* Once per second or faster, with RTCInt_GetDate(); returns the levels
+   closed, bit (1 << Stat_Level) */
+uint8_t Stats_Service(const DS1307_Time *now, uint32_t date);
+/* Closes the day if date differs from the open day's (the midnight alarm
+   calls it on time; Stats_Service catches up otherwise). 1 = closed. */
+uint8_t Stats_EndDay(uint32_t date);
+
+/* Open bucket plus the newest count-1 closed ones of that level.
+   Returns 0 when the window holds no samples. */
+uint8_t Stats_Window(Stat_Channel ch, Stat_Level lvl, uint16_t count, Stat_Summary *out);
+/* One closed bucket, age 1 = newest. Returns 0 if not (yet) kept. */
+uint8_t Stats_Bucket(Stat_Channel ch, Stat_Level lvl, uint16_t age, Stat_Acc *out);
+float   Stats_Ewma(Stat_Channel ch, uint8_t slow);   /* fast ~16 s, slow ~4 min at 1 Hz */
+
+#endif /* SENSOR_STATS_H */
@@ -7,10 +7,34 @@
 /* Default 7-bit address 0x48 (A2..A0=0) -> 8-bit on bus */
 #define LM75_I2C_ADDR8    (0x48u << 1)
 
+/* A2..A0 strapping gives 0x48..0x4F: one LM75 per greenhouse zone */
+#define LM75_ADDR7_FIRST  0x48u
+#define LM75_MAX_ZONES    8u
+
 /* Registers */
 #define LM75_REG_TEMP     0x00
 
-/* Read temperature in Celsius */
+/* One sensor instance */
+typedef struct {
+  uint8_t addr8;      /* 8-bit bus address */
+  uint8_t ptr_temp;   /* 1 = pointer reg known to be at TEMP -> 2-byte read only */
+  uint8_t ok;         /* last read succeeded */
+  float   c;          /* last good temperature */
+} LM75_Dev;
+
+void              LM75_InitDev(LM75_Dev *d, uint8_t addr7);
+HAL_StatusTypeDef LM75_Read(LM75_Dev *d);
+
+/* Zones: probe 0x48..0x4F at boot, then poll all of them in one burst.
+ * Zone i is the i-th responding address (ascending). */
+uint8_t      LM75_Discover(void);            /* returns zone count */
+uint8_t      LM75_PollAll(void);             /* returns zones read OK */
+uint8_t      LM75_ZoneCount(void);
+const float *LM75_ZoneTemps(void);           /* [LM75_ZoneCount()] °C, last good values */
+uint8_t      LM75_ZoneOk(uint8_t zone);
+uint8_t      LM75_ZoneAddr7(uint8_t zone);
+
+/* Read temperature in Celsius (zone 0, or the default address if none found) */
 HAL_StatusTypeDef LM75_ReadCelsius(float *out_c);
 
 #endif /* SENSORS_LM75_H */
@@ -0,0 +1,64 @@
+#ifndef SOIL_H
+#define SOIL_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Multi-probe soil moisture on ADC2 (PC1/PC2/PC3 = IN11..IN13).
+ *
+ * Excitation: TIM2 CH3/CH4 toggle complementary on PB10 (EXC_A) and PB11
+ * (EXC_B) every TIM2 period, i.e. a 2 kHz square wave whose polarity
+ * reverses each 250 µs, so no probe ever sees net DC (no electrolysis).
+ * Each probe is wired  EXC_A -- Rref -- node(ADC) -- probe -- EXC_B.
+ *
+ * Sampling: TIM2 CH2 (no pin) rises mid-period, well after the edge has
+ * settled, and triggers one ADC2 scan of all probes. DMA2 Stream2 writes
+ * the scans into a circular ping-pong buffer; the only interrupts are the
+ * DMA half/full events, so adding a probe adds one ADC rank and no CPU per
+ * sample. Scans alternate polarity A/B; Soil_Start() phase-locks the first
+ * scan so polarity is known from the buffer index alone.
+ *
+ * Resistive probe: x = vA / (vA + vB) = Rp / (Rref + Rp), independent of
+ * supply and excitation amplitude. Capacitive probe (own supply, analog
+ * output): x = mean of both phases. x is scaled to 0..65535 and mapped to
+ * volumetric water content through a two-point (dry/wet) calibration. */
+
+#define SOIL_PROBES          3u      /* must match ADC2 NbrOfConversion    */
+#define SOIL_SCANS_PER_HALF  128u    /* even; 128 x 250 µs = 32 ms blocks  */
+#define SOIL_AVG_SHIFT       3u      /* IIR over blocks: 1/8 new           */
+
+typedef enum {
+  SOIL_RESISTIVE = 0,       /* ratiometric, excitation-driven             */
+  SOIL_CAPACITIVE           /* self-powered analog output                 */
+} Soil_Kind;
+
+typedef struct {
+  uint8_t  kind;            /* Soil_Kind                                  */
+  uint16_t x_dry;           /* x reading in dry soil (0..65535)           */
+  uint16_t x_wet;           /* x reading at the wet reference point       */
+  uint16_t vwc_wet_x10;     /* VWC of the wet reference, 0.1 %            */
+} Soil_Cal;
+
+typedef struct {
+  uint16_t vwc_x10[SOIL_PROBES];  /* volumetric water content, 0.1 %     */
+  uint16_t x[SOIL_PROBES];        /* filtered ratio / level, 0..65535    */
+  uint8_t  ok[SOIL_PROBES];       /* 0 = no excitation seen (open wire)  */
+  uint32_t blocks;                /* processed blocks                    */
+  uint32_t overruns;              /* blocks dropped (main loop too late), filled by Soil_Get() */
+} Soil_Result;
+
+HAL_StatusTypeDef Soil_Start(void);     /* excitation + phase-locked ADC2 DMA */
+void              Soil_Stop(void);
+
+void    Soil_SetCal(uint8_t probe, const Soil_Cal *cal);
+
+/* Call from the main loop; returns 1 when a new result was published. */
+uint8_t Soil_Process(void);
+
+/* Latest result; 0 until the first block is done. */
+uint8_t Soil_Get(Soil_Result *out);
+
+/* ADC2 DMA half (0) / full (1) event, called from adc.c */
+void    Soil_OnDma(uint8_t half);
+
+#endif /* SOIL_H */
@@ -32,13 +32,31 @@ extern "C" {
 
 /* USER CODE END Includes */
 
+extern TIM_HandleTypeDef htim1;
+
+extern TIM_HandleTypeDef htim2;
+
+extern TIM_HandleTypeDef htim3;
+
 extern TIM_HandleTypeDef htim4;
 
+extern TIM_HandleTypeDef htim8;
+
+extern TIM_HandleTypeDef htim9;
+
+extern TIM_HandleTypeDef htim12;
+
 /* USER CODE BEGIN Private defines */
 
 /* USER CODE END Private defines */
 
+void MX_TIM1_Init(void);
+void MX_TIM2_Init(void);
+void MX_TIM3_Init(void);
 void MX_TIM4_Init(void);
+void MX_TIM8_Init(void);
+void MX_TIM9_Init(void);
+void MX_TIM12_Init(void);
 
 void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
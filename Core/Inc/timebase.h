@@ -0,0 +1,52 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include "main.h"
+#include <stdint.h>
+
+/* Monotonic 1 MHz timebase on TIM5 (32-bit, APB1).
+ *
+ * TIM5 free-runs at 1 MHz and wraps every 71.6 min; the update interrupt
+ * extends it to 64 bits. It replaces SysTick as the HAL time base:
+ * HAL_InitTick() (called by HAL_Init(), HAL_RCC_ClockConfig() and after
+ * every clock_mgr switch) sets the prescaler from the current APB1 timer
+ * clock without losing the count, and switches SysTick off. HAL_GetTick()
+ * is derived from the counter, so it keeps advancing with interrupts
+ * masked, and HAL_Delay() sleeps (WFI) until a compare match instead of
+ * polling a 1 kHz tick.
+ *
+ * 32-bit times (TB_Now, deadlines, timers) compare wrap-safe as long as
+ * the distance is below 2^31 us (35 min).
+ *
+ * Timers run their callback from the TIM5 interrupt (TICK_INT_PRIORITY,
+ * the lowest); keep them short and hand longer work to Defer_Post(). */
+
+typedef void (*TB_Callback)(void *ctx);
+
+typedef struct TB_Timer {
+  uint32_t         at;          /* next expiry, TB_Now() units   */
+  uint32_t         period;      /* 0 = one-shot                  */
+  TB_Callback      cb;
+  void            *ctx;
+  struct TB_Timer *next;
+  uint8_t          armed;
+} TB_Timer;
+
+uint32_t TB_Now(void);                       /* us, wraps every 2^32 */
+uint64_t TB_Now64(void);                     /* us since boot        */
+
+static inline uint32_t TB_Deadline(uint32_t us){ return TB_Now() + us; }
+static inline uint8_t  TB_Expired(uint32_t deadline){
+  return (uint8_t)((int32_t)(TB_Now() - deadline) >= 0);
+}
+
+void TB_DelayUs(uint32_t us);                /* busy wait             */
+void TB_SleepUntil(uint32_t deadline);       /* WFI; busy in ISR / masked */
+
+/* Compare-match timers: first expiry at 'at', then every period_us. */
+void TB_Start(TB_Timer *t, uint32_t at, uint32_t period_us, TB_Callback cb, void *ctx);
+void TB_Stop(TB_Timer *t);
+
+void TB_IRQHandler(void);
+
+#endif /* TIMEBASE_H */
@@ -0,0 +1,46 @@
+#ifndef TOUCH_PREDICT_H
+#define TOUCH_PREDICT_H
+
+#include <stdint.h>
+
+/* Drag predictor: per-axis alpha-beta-gamma tracker on filtered touch
+ * points, projecting the position forward by the measured render latency
+ * so dragged items stay under the finger. Pure C (no HAL).
+ *
+ * Overshoot limiting: the lead is capped in pixels, shrinks to zero when
+ * the finger slows below TP_STOP_SPEED and is cut back whenever the latest
+ * sample lands behind the prediction (finger decelerating). */
+
+#define TOUCH_PREDICT_ENABLE  1
+
+#define TP_ALPHA        0.50f   /* position gain                    */
+#define TP_BETA         0.25f   /* velocity gain                    */
+#define TP_GAMMA        0.04f   /* acceleration gain                */
+#define TP_MAX_LEAD_PX  24.0f   /* hard cap on projected distance   */
+#define TP_STOP_SPEED   0.02f   /* px/ms; below this no lead at all */
+#define TP_MAX_DT_MS    60U     /* gap that restarts the tracker    */
+
+typedef struct {
+    float    p, v, a;           /* position px, velocity px/ms, accel px/ms^2 */
+} TP_Axis;
+
+typedef struct {
+    TP_Axis  x, y;
+    uint32_t t_last;            /* ms timestamp of last update      */
+    uint8_t  n;                 /* samples since reset (saturates)  */
+    float    lead_scale;        /* 0..1, overshoot limiter state    */
+    float    latency_ms;        /* projection horizon               */
+    uint16_t max_x, max_y;      /* clamp bounds (screen size - 1)   */
+} TouchPredictor;
+
+void TouchPredict_Init   (TouchPredictor *tp, uint16_t screen_w, uint16_t screen_h);
+void TouchPredict_Reset  (TouchPredictor *tp, uint16_t x, uint16_t y, uint32_t now_ms);
+void TouchPredict_Update (TouchPredictor *tp, uint16_t x, uint16_t y, uint32_t now_ms);
+
+/* Feed one render-latency measurement (sample -> pixels, ms); smoothed internally. */
+void TouchPredict_AddLatency(TouchPredictor *tp, float latency_ms);
+
+/* Predicted position for drag rendering (clamped to the screen). */
+void TouchPredict_Get    (const TouchPredictor *tp, uint16_t *x, uint16_t *y);
+
+#endif /* TOUCH_PREDICT_H */
@@ -0,0 +1,34 @@
+#ifndef TOUCH_SM_H
+#define TOUCH_SM_H
+
+#include <stdint.h>
+
+/* Press/release state machine shared by the UI loop and trace replay.
+ * Pure C (no HAL) so recorded touch traces can be fed through the exact
+ * same logic off-target. */
+
+typedef enum {
+    TOUCH_EV_NONE = 0,   /* no change (idle, or pen still up)            */
+    TOUCH_EV_DOWN,       /* pen just went down at (x,y)                  */
+    TOUCH_EV_HOLD,       /* pen still down, (x,y) updated                */
+    TOUCH_EV_UP          /* pen released; (x,y) = last valid position    */
+} TouchEvent;
+
+typedef struct {
+    uint8_t  down;       /* 1 while pen is down                           */
+    uint16_t x, y;       /* last valid position                           */
+    uint16_t x0, y0;     /* position of the DOWN event                    */
+    uint32_t t_down;     /* timestamp of the DOWN event (ms)              */
+    uint32_t t_last;     /* timestamp of the last valid sample (ms)       */
+} TouchSM;
+
+void       TouchSM_Reset (TouchSM *sm);
+
+/* Feed one poll result. x/y are ignored when pressed==0. */
+TouchEvent TouchSM_Update(TouchSM *sm, uint8_t pressed,
+                          uint16_t x, uint16_t y, uint32_t now_ms);
+
+/* Time the pen has been held so far (valid while down and on UP). */
+static inline uint32_t TouchSM_HeldMs(const TouchSM *sm){ return sm->t_last - sm->t_down; }
+
+#endif /* TOUCH_SM_H */
@@ -0,0 +1,47 @@
+#ifndef TOUCH_TRACE_H
+#define TOUCH_TRACE_H
+
+#include <stdint.h>
+
+/* Touch trace recorder: raw XPT2046 samples + µs timestamps in RAM,
+ * dumped as CSV over the debug channel (ITM/SWO via printf).
+ *
+ * Dump format (one line per sample, after a '#' header line):
+ *   t_us,flags,idx,x,y,z1,z2
+ * flags: bit0 = pen down, bit1 = first sample of a ReadRaw burst.
+ * Pen-up is logged once per release (flags=0) so press/release timing
+ * can be replayed through touch_sm.c off-target.
+ * The dump ends with "# crc32=XXXXXXXX" (CRC peripheral, Integrity_Stream;
+ * the definition is in integrity_ref.h) over all lines between the '#'
+ * lines, so a replay can reject a damaged capture. */
+
+#define TOUCH_TRACE_ENABLE   0      /* 1 = start recording at boot, dump when full */
+#define TOUCH_TRACE_DEPTH    1024   /* samples (16 B each) */
+
+#define TT_PEN_DOWN          0x01u
+#define TT_BURST_START       0x02u
+
+typedef struct {
+    uint32_t t_us;       /* TIM5 timebase, µs since TouchTrace_Start */
+    uint16_t x, y;       /* raw 12-bit X/Y (single conversion, not averaged) */
+    uint16_t z1, z2;     /* raw 12-bit pressure pair (once per burst)        */
+    uint8_t  flags;      /* TT_PEN_DOWN | TT_BURST_START                     */
+    uint8_t  idx;        /* index inside the averaging burst                 */
+    uint16_t rsv;
+} TouchTraceSample;
+
+void     TouchTrace_Start(void);     /* clear buffer and arm recording */
+void     TouchTrace_Stop(void);
+uint8_t  TouchTrace_Active(void);
+uint8_t  TouchTrace_Full(void);
+uint16_t TouchTrace_Count(void);
+const TouchTraceSample *TouchTrace_Get(uint16_t i);
+
+/* Called by xpt2046.c; no-op unless recording. */
+void     TouchTrace_Record(uint8_t flags, uint8_t idx,
+                           uint16_t x, uint16_t y, uint16_t z1, uint16_t z2);
+
+/* Print header + all samples via printf (blocking, debug use only). */
+void     TouchTrace_Dump(void);
+
+#endif /* TOUCH_TRACE_H */
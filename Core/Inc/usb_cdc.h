@@ -0,0 +1,63 @@
+#ifndef USB_CDC_H
+#define USB_CDC_H
+
+#include <stdint.h>
+
+/* USB CDC-ACM device (virtual COM port) for log export and live telemetry.
+ *
+ * Two transmit sources share the bulk IN endpoint:
+ *  - segments: USBCDC_Submit() queues a caller-owned buffer by reference;
+ *    it goes from that memory straight into the endpoint FIFO, and `done`
+ *    is called once it is on the wire (or dropped by a bus reset). Use
+ *    this for trace rings, log records and telemetry frames.
+ *  - console: USBCDC_Write() copies into a ring (printf output); the ring
+ *    itself is then sent in place.
+ *
+ * Transfers span many packets (up to USBFS_XFER_MAX), and EP1 has an
+ * 8-packet TX FIFO refilled at half-empty, so the host is not starved
+ * between transfers.
+ *
+ * Flow control never blocks: with no host terminal open (DTR low) output
+ * is discarded, and a full queue / ring rejects the data and counts it.
+ *
+ * HAL-free class logic on top of usb_fs.h; USBCDC_Init() brings the core
+ * up. Segment `done` callbacks run in the USB interrupt. */
+
+#define USBCDC_TXQ_DEPTH    8u      /* queued segments                     */
+#define USBCDC_RING_SIZE    2048u   /* console ring, power of two          */
+
+typedef void (*USBCDC_Done)(void *ctx);
+typedef void (*USBCDC_Rx)(const uint8_t *data, uint32_t len);
+
+typedef struct {
+  uint32_t tx_bytes;
+  uint32_t tx_xfers;
+  uint32_t rx_bytes;
+  uint32_t dropped;        /* bytes rejected: queue or ring full           */
+  uint32_t baud;           /* host line coding (informational)             */
+} USBCDC_Stats;
+
+void     USBCDC_Init(void);
+
+/* Configured, not suspended and a terminal has the port open (DTR). */
+uint8_t  USBCDC_Ready(void);
+
+/* Main context. 0 = not accepted (not ready or queue full); `done` is not
+   called in that case. */
+uint8_t  USBCDC_Submit(const void *data, uint32_t len, USBCDC_Done done, void *ctx);
+
+/* Main context only -- the ring index is not reentrant, so an interrupt
+   must not write while the main loop is inside USBCDC_Write() (main.c's
+   __io_putchar skips the ring in handler mode). Returns bytes taken. */
+uint32_t USBCDC_Write(const void *data, uint32_t len);
+
+/* Main loop: starts a transfer for console bytes written since the last
+   call. */
+void     USBCDC_Poll(void);
+
+/* Host -> device data, called from the USB interrupt. */
+void     USBCDC_SetRxHandler(USBCDC_Rx fn);
+
+void     USBCDC_GetStats(USBCDC_Stats *out);
+
+#endif /* USB_CDC_H */
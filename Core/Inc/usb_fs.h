@@ -0,0 +1,46 @@
+#ifndef USB_FS_H
+#define USB_FS_H
+
+#include <stdint.h>
+
+/* Endpoint layer between the USB class code and the OTG FS core.
+ *
+ * usb_fs.c implements it on target (register level, device mode, PA11 /
+ * PA12, VBUS sensing off). The class (usb_cdc.c) only talks to the
+ * functions below and implements the USBFS_On* callbacks, so it carries no
+ * HAL or register dependency and can run against a simulated endpoint
+ * layer off-target.
+ *
+ * Callbacks run in the OTG_FS interrupt. IN transfers are sent straight
+ * from the caller's memory into the endpoint TX FIFO (no staging buffer);
+ * the memory must stay valid until USBFS_OnInDone(). */
+
+#define USBFS_EP0_MPS      64u
+#define USBFS_BULK_MPS     64u
+#define USBFS_INT_MPS      8u
+
+#define USBFS_EP_BULK      1u     /* EP1 IN/OUT: CDC data                  */
+#define USBFS_EP_NOTIFY    2u     /* EP2 IN: CDC notifications             */
+
+#define USBFS_XFER_MAX     32768u /* bytes per IN transfer (PKTCNT limit)  */
+
+/* ---- Endpoint layer (usb_fs.c) ---- */
+void USBFS_Init(void);                                    /* connects D+ pull-up */
+void USBFS_EpIn (uint8_t ep, const void *p, uint32_t len);        /* len 0 = ZLP */
+void USBFS_EpOut(uint8_t ep, void *buf, uint32_t len);            /* arm reception */
+void USBFS_EpStall(uint8_t ep);                           /* EP0: both directions */
+void USBFS_SetAddress(uint8_t addr);
+void USBFS_Configure(uint8_t on);                         /* open/close EP1, EP2 */
+uint32_t USBFS_UniqueId(uint8_t word);                   /* 96-bit device ID, word 0..2 */
+void USBFS_Lock(void);                                    /* mask the OTG IRQ    */
+void USBFS_Unlock(void);
+void USBFS_IRQHandler(void);
+
+/* ---- Class callbacks (usb_cdc.c) ---- */
+void USBFS_OnReset(void);
+void USBFS_OnSuspend(uint8_t suspended);
+void USBFS_OnSetup(const uint8_t setup[8]);
+void USBFS_OnInDone(uint8_t ep);
+void USBFS_OnOutDone(uint8_t ep, uint32_t len);
+
+#endif /* USB_FS_H */
@@ -17,6 +17,26 @@ typedef struct {
     uint8_t  pressed;    /* 1 = touch detected (IRQ low) */
 } XPT_TouchPoint;
 
+/* One DMA touch burst: dummy pair, Z1/Z2, XPT_BURST_N x (Y,X) in a single CS window,
+ * plus the conversions of one due aux channel, if any */
+#define XPT_BURST_N     6
+
+typedef struct {
+    uint16_t x, y;                          /* averaged raw 12-bit      */
+    uint16_t z1, z2;                        /* raw pressure pair        */
+    uint16_t xs[XPT_BURST_N], ys[XPT_BURST_N]; /* individual conversions */
+} XPT_Burst;
+
+/* Auxiliary ADC inputs, sampled in the touch DMA burst */
+typedef enum {
+    XPT_AUX_VBAT = 0,    /* VBAT pin, 0..~6 V via on-chip /4 divider */
+    XPT_AUX_AUXIN,       /* AUX pin, 0..VREF                         */
+    XPT_AUX_TEMP,        /* die temperature (TEMP1 - TEMP0 method)   */
+    XPT_AUX_COUNT
+} XPT_AuxChannel;
+
+#define XPT_AUX_VREF_MV  2500u   /* internal reference */
+
 /* API */
 void XPT_Init(SPI_HandleTypeDef *hspi, uint8_t rot_deg,
               uint16_t screen_w, uint16_t screen_h);
@@ -24,6 +44,11 @@ void XPT_Init(SPI_HandleTypeDef *hspi, uint8_t rot_deg,
 /* Set raw calibration (read once from 4 corners and update here). */
 void XPT_SetCalibration(int32_t x_min, int32_t x_max,
                         int32_t y_min, int32_t y_max);
+void XPT_GetCalibration(int32_t *x_min, int32_t *x_max,
+                        int32_t *y_min, int32_t *y_max);
+
+/* Map raw 12-bit averages to screen coordinates (no SPI; used by trace replay) */
+uint8_t XPT_MapRaw(uint16_t rx, uint16_t ry, uint16_t *sx, uint16_t *sy);
 
 /* Read mapped point (returns 1 if pressed and valid, fills tp) */
 uint8_t XPT_GetPoint(XPT_TouchPoint *tp);
@@ -31,7 +56,21 @@ uint8_t XPT_GetPoint(XPT_TouchPoint *tp);
 /* Optional: read raw 12-bit averages (no mapping) */
 uint8_t XPT_ReadRaw(uint16_t *raw_x, uint16_t *raw_y);
 
+/* Async burst (XPT_ReadRaw uses these and sleeps until done). SPI1 is shared
+ * with the TFT: do not draw between XPT_BurstStart() and completion. */
+uint8_t XPT_BurstStart(void);               /* 0 if pen up or SPI busy   */
+uint8_t XPT_BurstBusy(void);
+uint8_t XPT_BurstTake(XPT_Burst *out);      /* 1 once per finished burst */
+
 /* Extended: mapped + raw in one call (for on-screen debug) */
 uint8_t XPT_GetPointWithRaw(XPT_TouchPoint *tp, uint16_t *raw_x, uint16_t *raw_y);
 
+/* Aux channels: enable with a refresh period (0 = off). One due channel per
+ * call is appended to the DMA burst of XPT_GetPoint*() / XPT_ReadRaw() /
+ * XPT_BurstStart(); with the pen up it is sent as a short burst on its own. */
+void    XPT_AuxEnable(XPT_AuxChannel ch, uint16_t period_ms);
+uint8_t XPT_AuxGetRaw(XPT_AuxChannel ch, uint16_t *raw);      /* 0 until first sample */
+uint8_t XPT_AuxGetMillivolts(XPT_AuxChannel ch, uint32_t *mv); /* VBAT / AUXIN only */
+uint8_t XPT_AuxGetTempC10(int16_t *t_c10);                      /* die temp, 0.1 °C */
+
 #endif
@@ -0,0 +1,24 @@
+#ifndef XPT_MAP_H
+#define XPT_MAP_H
+
+#include <stdint.h>
+
+/* Burst filter and raw -> screen mapping of the XPT2046 driver.
+ * Pure C (no HAL) so the host trace replay (Tests/host/touch_replay.c)
+ * runs exactly the code the target runs. */
+
+typedef struct {
+    int32_t  x_min, x_max;   /* raw calibration                    */
+    int32_t  y_min, y_max;
+    uint16_t w, h;           /* displayed (rotated) size           */
+    uint16_t rot;            /* 0/90/180/270                       */
+} XPT_Map;
+
+/* Filter one burst of n raw conversions down to a single value. */
+uint16_t XPT_MapFilter(const uint16_t *v, uint8_t n);
+
+/* Returns 0 if the calibration is unusable. */
+uint8_t  XPT_MapApply(const XPT_Map *m, uint16_t rx, uint16_t ry,
+                      uint16_t *sx, uint16_t *sy);
+
+#endif /* XPT_MAP_H */
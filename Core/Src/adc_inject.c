@@ -0,0 +1,149 @@
+#include "adc_inject.h"
+#include "adc.h"
+#include "deferred.h"
+#include "timebase.h"
+
+/* ====== Request ring ======
+ * One slot per request from queueing until its callback has run:
+ *   [d_tail, q_head)  converted, awaiting delivery  (consumer: PendSV)
+ *   [q_head, q_tail)  queued, head in conversion    (consumer: ADC ISR)
+ * A result keeps its slot until delivered, so none can be dropped. */
+typedef struct {
+  uint32_t        channel;
+  uint32_t        sample_time;
+  ADC_InjCallback cb;
+  void           *ctx;
+  uint16_t        value;
+} InjReq;
+
+static InjReq q[ADC_INJ_QUEUE_LEN];
+static volatile uint8_t d_tail = 0, q_head = 0, q_tail = 0;
+static volatile uint8_t active = 0;
+static volatile uint8_t retry  = 0;             /* Defer_Post failed: PendSV delivers directly */
+static volatile uint32_t start_fail = 0;        /* head could not be started (config / start) */
+
+#define NEXT(i)  ((uint8_t)(((i) + 1u) % ADC_INJ_QUEUE_LEN))
+
+/* Callers keep the ADC interrupt out (ADC ISR itself or PRIMASK): the
+   completion must not see `active` still clear. On failure the request
+   stays at the head and inj_deliver() or the next request retries it. */
+static void start_head(void){
+  const InjReq *r = &q[q_head];
+  ADC_InjectionConfTypeDef c = {0};
+  c.InjectedChannel               = r->channel;
+  c.InjectedRank                  = 1;
+  c.InjectedNbrOfConversion       = 1;
+  c.InjectedSamplingTime          = r->sample_time;
+  c.InjectedOffset                = 0;
+  c.ExternalTrigInjecConv         = ADC_INJECTED_SOFTWARE_START;
+  c.ExternalTrigInjecConvEdge     = ADC_EXTERNALTRIGINJECCONVEDGE_NONE;
+  c.AutoInjectedConv              = DISABLE;
+  c.InjectedDiscontinuousConvMode = DISABLE;
+  if (HAL_ADCEx_InjectedConfigChannel(&hadc1, &c) != HAL_OK ||
+      HAL_ADCEx_InjectedStart_IT(&hadc1) != HAL_OK){
+    start_fail++;
+    return;
+  }
+  active = 1;
+}
+
+/* Bottom half: run the user callbacks outside the ADC interrupt. PendSV
+   only (posted item or ADC_Inject_Retry), so there is a single consumer. */
+static void inj_deliver(void *arg){
+  (void)arg;
+  while (d_tail != q_head){
+    InjReq r = q[d_tail];                       /* copy: the slot is reusable once released */
+    d_tail = NEXT(d_tail);
+    if (r.cb) r.cb(r.channel, r.value, r.ctx);
+  }
+
+  uint32_t pm = __get_PRIMASK();              /* restart a head the ADC ISR failed to start */
+  __disable_irq();
+  if (!active && q_head != q_tail) start_head();
+  __set_PRIMASK(pm);
+}
+
+void HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef *hadc){
+  if (hadc->Instance != ADC1 || !active) return;
+
+  q[q_head].value = (uint16_t)HAL_ADCEx_InjectedGetValue(hadc, ADC_INJECTED_RANK_1);
+  q_head = NEXT(q_head);
+  active = 0;
+
+  if (q_head != q_tail) start_head();         /* next queued request, before the callbacks */
+  if (!Defer_Post(inj_deliver, NULL)){        /* deferred queue full: PendSV picks it up */
+    retry = 1;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+  }
+}
+
+void ADC_Inject_Retry(void){
+  if (!retry) return;
+  retry = 0;                                  /* a later completion sets it and re-pends */
+  inj_deliver(NULL);
+}
+
+HAL_StatusTypeDef ADC_Inject_Request(uint32_t channel, uint32_t sample_time,
+                                     ADC_InjCallback cb, void *ctx){
+  HAL_StatusTypeDef st = HAL_OK;             /* queued; a failed start is retried */
+  uint32_t pm = __get_PRIMASK();
+  __disable_irq();
+  if (NEXT(q_tail) == d_tail){                /* every slot queued or awaiting delivery */
+    st = HAL_BUSY;
+  } else {
+    q[q_tail] = (InjReq){ channel, sample_time, cb, ctx, 0 };
+    q_tail = NEXT(q_tail);
+    if (!active) start_head();
+  }
+  __set_PRIMASK(pm);
+  return st;
+}
+
+uint8_t ADC_Inject_Pending(void){
+  return (uint8_t)((q_tail + ADC_INJ_QUEUE_LEN - q_head) % ADC_INJ_QUEUE_LEN);
+}
+
+uint32_t ADC_Inject_StartFailures(void){ return start_fail; }
+
+/* ====== Blocking helper ====== */
+typedef struct { volatile uint8_t done, busy; uint16_t v; } InjWait;
+
+static void wait_cb(uint32_t channel, uint16_t value, void *ctx){
+  (void)channel;
+  InjWait *w = (InjWait *)ctx;
+  w->v    = value;
+  w->done = 1;
+  w->busy = 0;
+}
+
+static void wake_cb(void *ctx){ (void)ctx; }   /* the interrupt itself ends the WFI */
+
+HAL_StatusTypeDef ADC_Inject_Read(uint32_t channel, uint32_t sample_time,
+                                  uint16_t *value, uint32_t timeout_ms){
+  static InjWait w;                          /* outlives a timed-out request */
+  if (w.busy) return HAL_BUSY;               /* previous read still queued */
+  w.done = 0;
+  w.busy = 1;
+  HAL_StatusTypeDef st = ADC_Inject_Request(channel, sample_time, wait_cb, &w);
+  if (st != HAL_OK){ w.busy = 0; return st; }
+
+  /* Sleep until the callback (PendSV) or the deadline timer wakes us.
+     PRIMASK makes the check-then-WFI race-free; a pending IRQ still
+     wakes the core and is taken once re-enabled. */
+  static TB_Timer wake;
+  uint32_t dl = TB_Deadline(timeout_ms * 1000u);
+  TB_Start(&wake, dl, 0, wake_cb, NULL);
+  uint32_t pm = __get_PRIMASK();
+  __disable_irq();
+  while (!w.done && !TB_Expired(dl)){
+    __WFI();
+    __set_PRIMASK(pm);
+    __disable_irq();
+  }
+  __set_PRIMASK(pm);
+  TB_Stop(&wake);
+
+  if (!w.done) return HAL_TIMEOUT;
+  if (value) *value = w.v;
+  return HAL_OK;
+}
@@ -0,0 +1,163 @@
+#include "bkp_sram.h"
+#include "relay_zones.h"
+#include "light_capture.h"
+#include "event_bus.h"
+#include "deferred.h"
+#include "integrity.h"
+#include <stdio.h>
+#include <stddef.h>
+
+#define R  BKP_REGION
+#define SRAM_END   (SRAM1_BASE + 0x20000u)      /* SRAM1 112 KB + SRAM2 16 KB */
+
+static BKP_Fault last_fault;
+static uint8_t   have_fault = 0;
+static uint8_t   fault_crc_ok = 0;
+static uint32_t  sec_t0     = 0;
+
+/* CRC unit: checked at boot (clock enabled in BKP_Init, ahead of
+   Integrity_Init) and written from fault handlers, where it may be mid-job. */
+static uint32_t fault_crc(const BKP_Fault *f, uint8_t in_fault){
+  return in_fault ? Integrity_CRC32_Force(f, offsetof(BKP_Fault, crc))
+                  : Integrity_CRC32(f, offsetof(BKP_Fault, crc));
+}
+
+void BKP_Init(void){
+  __HAL_RCC_PWR_CLK_ENABLE();
+  HAL_PWR_EnableBkUpAccess();
+  __HAL_RCC_BKPSRAM_CLK_ENABLE();
+  __HAL_RCC_CRC_CLK_ENABLE();                    /* fault record CRC */
+  (void)HAL_PWREx_EnableBkUpReg();               /* retain contents on VBAT */
+
+  if (R->magic != BKP_MAGIC || R->size != sizeof(BKP_Region)){
+    volatile uint32_t *w = (volatile uint32_t *)BKPSRAM_BASE;
+    for (uint32_t i = 0; i < sizeof(BKP_Region) / 4u; i++) w[i] = 0;
+    R->magic = BKP_MAGIC;
+    R->size  = sizeof(BKP_Region);
+  }
+
+  R->boots++;
+  R->reset_csr     = RCC->CSR;
+  R->uptime_boot_s = 0;
+  __HAL_RCC_CLEAR_RESET_FLAGS();
+
+  if (R->fault.kind != BKP_FAULT_NONE){
+    last_fault   = *(const BKP_Fault *)&R->fault;
+    have_fault   = 1;
+    fault_crc_ok = (uint8_t)(fault_crc(&last_fault, 0) == last_fault.crc);
+    R->fault.kind = BKP_FAULT_NONE;              /* reported once */
+  }
+  sec_t0 = HAL_GetTick();
+}
+
+const BKP_Fault *BKP_LastFault(void){ return have_fault ? &last_fault : NULL; }
+uint8_t          BKP_LastFaultValid(void){ return (uint8_t)(have_fault && fault_crc_ok); }
+
+void BKP_Tick(uint32_t now_ms){
+  if (now_ms - sec_t0 < 1000u) return;
+  sec_t0 += 1000u;
+  R->uptime_total_s++;
+  R->uptime_boot_s++;
+
+  LightCap_Result lr;
+  EventBus_Stats  es;
+  Defer_Stats     ds;
+  if (LightCap_Get(&lr)) BKP_Max(&R->light_max_cyc, lr.cycles_max);
+  EventBus_GetStats(&es);
+  BKP_Max(&R->event_lat_max_cyc, es.lat_max);
+  Defer_GetStats(&ds);
+  BKP_Max(&R->defer_lat_max_cyc, ds.lat_max);
+}
+
+void BKP_Report(void){
+  printf("# bkp boots=%lu faults=%lu reset_csr=0x%08lX up_total=%lus i2c_err=%lu\r\n",
+         (unsigned long)R->boots, (unsigned long)R->faults, (unsigned long)R->reset_csr,
+         (unsigned long)R->uptime_total_s, (unsigned long)R->i2c_errors);
+  printf("# bkp max_cyc loop=%lu light=%lu evt_lat=%lu defer_lat=%lu\r\n",
+         (unsigned long)R->loop_max_cyc, (unsigned long)R->light_max_cyc,
+         (unsigned long)R->event_lat_max_cyc, (unsigned long)R->defer_lat_max_cyc);
+  if (!have_fault) return;
+
+  const BKP_Fault *f = &last_fault;
+  printf("# fault kind=%lu boot=%lu up=%lus zones=0x%02lX crc=%s\r\n",
+         (unsigned long)f->kind, (unsigned long)f->boot,
+         (unsigned long)f->uptime_s, (unsigned long)f->zones,
+         fault_crc_ok ? "ok" : "BAD");
+  printf("# pc=0x%08lX lr=0x%08lX xpsr=0x%08lX sp=0x%08lX exc=0x%08lX\r\n",
+         (unsigned long)f->pc, (unsigned long)f->lr, (unsigned long)f->xpsr,
+         (unsigned long)f->sp, (unsigned long)f->exc_return);
+  printf("# r0=0x%08lX r1=0x%08lX r2=0x%08lX r3=0x%08lX r12=0x%08lX\r\n",
+         (unsigned long)f->r0, (unsigned long)f->r1, (unsigned long)f->r2,
+         (unsigned long)f->r3, (unsigned long)f->r12);
+  printf("# cfsr=0x%08lX hfsr=0x%08lX mmfar=0x%08lX bfar=0x%08lX\r\n",
+         (unsigned long)f->cfsr, (unsigned long)f->hfsr,
+         (unsigned long)f->mmfar, (unsigned long)f->bfar);
+  for (uint32_t i = 0; i < BKP_STACK_WORDS; i++)
+    printf("%08lX%s", (unsigned long)f->stack[i], (i % 8u == 7u) ? "\r\n" : " ");
+}
+
+/* ====== Fault capture (handler mode, interrupts masked) ====== */
+static void snap_common(uint32_t kind){
+  R->fault.kind     = kind;
+  R->fault.cfsr     = SCB->CFSR;
+  R->fault.hfsr     = SCB->HFSR;
+  R->fault.mmfar    = SCB->MMFAR;
+  R->fault.bfar     = SCB->BFAR;
+  R->fault.boot     = R->boots;
+  R->fault.uptime_s = R->uptime_boot_s;
+  R->fault.zones    = RelayZones_Actual();
+  R->faults++;
+}
+
+/* A stacked exception frame: xPSR has the Thumb bit, PC is a halfword
+ * address in flash. */
+static uint8_t is_frame(const uint32_t *p){
+  return (uint8_t)((p[7] & (1u << 24)) && !(p[6] & 1u) &&
+                   p[6] >= FLASH_BASE && p[6] < FLASH_END);
+}
+
+static void save_stack(const uint32_t *from){
+  for (uint32_t i = 0; i < BKP_STACK_WORDS; i++){
+    if ((uint32_t)(uintptr_t)&from[i] >= SRAM_END) { R->fault.stack[i] = 0; continue; }
+    R->fault.stack[i] = from[i];
+  }
+}
+
+void BKP_FaultFromException(uint32_t kind, uint32_t exc_return){
+  __disable_irq();
+  snap_common(kind);
+  R->fault.exc_return = exc_return;
+
+  /* Thread mode on PSP: the frame is exactly at PSP. On MSP the handler's
+     own prologue sits below it, so search a few words upwards. */
+  const uint32_t *sp = (const uint32_t *)(uintptr_t)((exc_return & 4u) ? __get_PSP() : __get_MSP());
+  const uint32_t *f  = NULL;
+  if (exc_return & 4u) f = sp;
+  else for (uint32_t i = 0; i < 32u && !f; i++){
+    if ((uint32_t)(uintptr_t)(sp + i + 8) > SRAM_END) break;
+    if (is_frame(sp + i)) f = sp + i;
+  }
+
+  if (f){
+    R->fault.r0 = f[0]; R->fault.r1 = f[1]; R->fault.r2 = f[2]; R->fault.r3 = f[3];
+    R->fault.r12 = f[4]; R->fault.lr = f[5]; R->fault.pc = f[6]; R->fault.xpsr = f[7];
+    R->fault.sp  = (uint32_t)(uintptr_t)(f + 8);
+    save_stack(f + 8);
+  } else {
+    R->fault.sp = (uint32_t)(uintptr_t)sp;
+    save_stack(sp);
+  }
+  R->fault.crc = fault_crc((const BKP_Fault *)&R->fault, 1);
+  NVIC_SystemReset();
+}
+
+void BKP_FaultFromError(uint32_t caller_pc){
+  __disable_irq();
+  snap_common(BKP_FAULT_ERROR);
+  const uint32_t *sp = (const uint32_t *)(uintptr_t)__get_MSP();
+  R->fault.pc = caller_pc & ~1u;
+  R->fault.sp = (uint32_t)(uintptr_t)sp;
+  save_stack(sp);
+  R->fault.crc = fault_crc((const BKP_Fault *)&R->fault, 1);
+  NVIC_SystemReset();
+}
@@ -0,0 +1,129 @@
+#include "buzzer.h"
+#include "timebase.h"
+
+/* One note, precomputed: TIM12 period and high time, and how long */
+typedef struct {
+  uint16_t arr;                               /* tone period - 1         */
+  uint16_t ccr;                               /* high ticks, 0 = rest    */
+  uint32_t us;                                /* duration                */
+} Buz_Step;
+
+#define BUZ_MIN_HZ     65u                    /* period must fit the 16-bit ARR */
+#define BUZ_MAX_HZ     10000u
+#define BUZ_REST_ARR   (BUZ_TICK_HZ / 1000u - 1u)   /* any period will do at CCR1 = 0 */
+
+#define OC1M_PWM1      (TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1)
+#define OC1M_LOW       TIM_CCMR1_OC1M_2       /* forced inactive */
+
+const Buz_Note Buz_Click[1]    = { { 4000u, 12u } };
+const Buz_Note Buz_Irrigate[3] = { { 2000u, 80u }, { 2500u, 80u }, { 3000u, 140u } };
+const Buz_Note Buz_Alarm[4]    = { { 3200u, 150u }, { 0u, 60u }, { 3200u, 150u }, { 0u, 640u } };
+
+static TIM_TypeDef *tim;
+static TB_Timer     note_tmr;
+static Buz_Step     steps[BUZ_MAX_STEPS];
+static uint8_t      n_steps;
+static uint8_t      loop_seq;
+static uint8_t      vol = BUZ_VOL_MAX / 2u;
+static Buz_Prio     cur_prio;
+
+static volatile uint8_t  playing;
+static uint8_t           si;                  /* next step                    */
+static uint32_t          t_end;               /* end of the current note, us  */
+
+static void oc1_mode(uint32_t m){
+  tim->CCMR1 = (tim->CCMR1 & ~(uint32_t)TIM_CCMR1_OC1M) | m;
+}
+
+/* ====== Note boundaries (TIM5 interrupt) ====== */
+static void halt(void){
+  oc1_mode(OC1M_LOW);                         /* pin low at once, mid-period or not */
+  tim->CR1 &= ~(uint32_t)TIM_CR1_CEN;
+  playing = 0;
+}
+
+/* Preloaded: takes effect at the end of the tone period now running */
+static void load(const Buz_Step *s){
+  tim->ARR  = s->arr;
+  tim->CCR1 = s->ccr;
+}
+
+/* Deadlines are chained from the previous one, not from "now", so a late
+   interrupt does not stretch the sequence. */
+static void next_note(void *ctx){
+  (void)ctx;
+  if (si >= n_steps){
+    if (!loop_seq){ halt(); return; }
+    si = 0;
+  }
+  const Buz_Step *s = &steps[si++];
+  load(s);
+  t_end += s->us;
+  TB_Start(&note_tmr, t_end, 0, next_note, NULL);
+}
+
+/* ====== Table ====== */
+static void compile(const Buz_Note *seq, uint8_t n){
+  for (uint8_t i = 0; i < n; i++){
+    Buz_Step *s  = &steps[i];
+    uint32_t  hz = seq[i].hz;
+    s->us = (seq[i].ms ? seq[i].ms : 1u) * 1000u;
+    if (hz == 0u || vol == 0u){
+      s->arr = (uint16_t)BUZ_REST_ARR;
+      s->ccr = 0;
+      continue;
+    }
+    if (hz < BUZ_MIN_HZ) hz = BUZ_MIN_HZ;
+    if (hz > BUZ_MAX_HZ) hz = BUZ_MAX_HZ;
+    uint32_t per = (BUZ_TICK_HZ + hz / 2u) / hz;
+    s->arr = (uint16_t)(per - 1u);
+    s->ccr = (uint16_t)(per * vol / (2u * BUZ_VOL_MAX));
+  }
+}
+
+/* Once the note timer is stopped nothing else touches TIM12 or the table */
+static void stop_now(void){
+  TB_Stop(&note_tmr);
+  halt();
+}
+
+/* ====== API ====== */
+void Buz_Init(TIM_HandleTypeDef *htim){
+  tim = htim->Instance;
+  tim->CR1 &= ~(uint32_t)TIM_CR1_CEN;
+  tim->CR1 |= TIM_CR1_URS;                    /* UG only reloads, no update flag */
+  oc1_mode(OC1M_LOW);
+  tim->CCER |= TIM_CCER_CC1E;                 /* pin follows OC1, held low */
+  playing = 0;
+}
+
+uint8_t Buz_Play(const Buz_Note *seq, uint8_t n, Buz_Prio prio, uint8_t loop){
+  if (!tim || !seq || n == 0u) return 0;
+  if (playing && prio < cur_prio) return 0;
+  if (n > BUZ_MAX_STEPS) n = BUZ_MAX_STEPS;
+
+  stop_now();
+  compile(seq, n);
+  n_steps  = n;
+  loop_seq = loop;
+  cur_prio = prio;
+  si       = 1;
+  playing  = 1;
+  load(&steps[0]);
+  tim->EGR = TIM_EGR_UG;                      /* first note into the active registers, CNT = 0 */
+  oc1_mode(OC1M_PWM1);
+  tim->CR1 |= TIM_CR1_CEN;
+  t_end = TB_Now() + steps[0].us;
+  TB_Start(&note_tmr, t_end, 0, next_note, NULL);
+  return 1;
+}
+
+void Buz_Stop(Buz_Prio prio){
+  if (tim && playing && cur_prio <= prio) stop_now();
+}
+
+void Buz_SetVolume(uint8_t v){
+  vol = (v > BUZ_VOL_MAX) ? (uint8_t)BUZ_VOL_MAX : v;
+}
+
+uint8_t Buz_Busy(void){ return playing; }
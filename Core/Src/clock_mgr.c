@@ -0,0 +1,196 @@
+#include "clock_mgr.h"
+#include "spi.h"
+#include "tim.h"
+#include "i2c_sw.h"
+#include "i2c_dma.h"
+#include "xpt2046.h"
+#include "cycles.h"
+
+/* RCC_CFGR field values */
+typedef struct { uint32_t hpre, ppre1, ppre2, latency; } Level_Cfg;
+
+static const Level_Cfg lvl_cfg[CLK_LVL_COUNT] = {
+  [CLK_LVL_IDLE]  = { RCC_CFGR_HPRE_DIV4, RCC_CFGR_PPRE1_DIV1, RCC_CFGR_PPRE2_DIV1, FLASH_LATENCY_1 },
+  [CLK_LVL_BOOST] = { RCC_CFGR_HPRE_DIV1, RCC_CFGR_PPRE1_DIV4, RCC_CFGR_PPRE2_DIV2, FLASH_LATENCY_5 },
+};
+
+typedef struct { uint32_t hclk, pclk1, pclk2, tim_apb1, tim_apb2; } Clocks;
+
+static Clock_Level lvl = CLK_LVL_BOOST;
+static uint32_t    holds = 0;
+static uint32_t    cur_mhz = 168u;
+static uint32_t    t_mark = 0;                  /* DWT at last residency update */
+static uint64_t    res_us[CLK_LVL_COUNT];
+static Clock_Stats st;
+
+static void clocks_now(Clocks *c){
+  c->hclk     = HAL_RCC_GetHCLKFreq();
+  c->pclk1    = HAL_RCC_GetPCLK1Freq();
+  c->pclk2    = HAL_RCC_GetPCLK2Freq();
+  c->tim_apb1 = ((RCC->CFGR & RCC_CFGR_PPRE1) == 0) ? c->pclk1 : 2U * c->pclk1;
+  c->tim_apb2 = ((RCC->CFGR & RCC_CFGR_PPRE2) == 0) ? c->pclk2 : 2U * c->pclk2;
+}
+
+/* DWT cycles since the last call, charged to the current level. Called at
+   least once per loop pass, well inside the 25 s CYCCNT wrap. */
+static void account(void){
+  uint32_t now = DWT->CYCCNT;
+  res_us[lvl] += (now - t_mark) / cur_mhz;
+  t_mark = now;
+}
+
+/* ====== Dependants ====== */
+static uint32_t scale(uint32_t v, uint32_t f_old, uint32_t f_new){
+  return (uint32_t)(((uint64_t)v * f_new + f_old / 2u) / f_old);
+}
+
+/* Keep a timer's time base across a clock change. If the prescaler can
+ * absorb the ratio exactly it is rewritten. With `now` it is loaded at once
+ * by an update event, with the count put back; otherwise it takes effect at
+ * the next update and the period in progress ends at the new input rate.
+ * (UG also fires TRGO, so timers that trigger something must wait.) If the
+ * prescaler cannot absorb the ratio, the period, the output-compare values
+ * and the running count are scaled in place, with preload bypassed, so the
+ * current period still ends on time. Input-capture channels are left alone. */
+static void tim_retime(TIM_TypeDef *t, uint32_t f_old, uint32_t f_new, uint8_t now){
+  if (f_old == f_new) return;
+  uint64_t div = (uint64_t)(t->PSC + 1u) * f_new;
+  if (div % f_old == 0u && div >= f_old){
+    t->PSC = (uint32_t)(div / f_old) - 1u;
+    if (now){
+      uint32_t cnt = t->CNT;
+      t->EGR = TIM_EGR_UG;
+      t->CNT = cnt;
+    }
+    return;
+  }
+
+  uint32_t cr1 = t->CR1, ccmr[2] = { t->CCMR1, t->CCMR2 };
+  volatile uint32_t *ccr[4] = { &t->CCR1, &t->CCR2, &t->CCR3, &t->CCR4 };
+  t->CR1 = cr1 & ~TIM_CR1_ARPE;
+  for (uint32_t ch = 0; ch < 4u; ch++){
+    uint32_t sh = (ch & 1u) * 8u;
+    if ((ccmr[ch >> 1] >> sh) & 3u) continue;   /* CCxS != 0: input */
+    uint32_t pe = TIM_CCMR1_OC1PE << sh;
+    if (ch < 2u) t->CCMR1 &= ~pe; else t->CCMR2 &= ~pe;
+    *ccr[ch] = scale(*ccr[ch], f_old, f_new);
+  }
+  t->ARR = scale(t->ARR + 1u, f_old, f_new) - 1u;
+  t->CNT = scale(t->CNT, f_old, f_new);
+  t->CCMR1 = ccmr[0];
+  t->CCMR2 = ccmr[1];
+  t->CR1   = cr1;
+}
+
+/* Same or slower SCK than before. */
+static void spi_retime(SPI_HandleTypeDef *h, uint32_t f_old, uint32_t f_new){
+  if (f_old == f_new) return;
+  uint32_t br  = (h->Instance->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos;
+  uint32_t sck = f_old >> (br + 1u);
+  uint32_t nb  = 0;
+  while (nb < 7u && (f_new >> (nb + 1u)) > sck) nb++;
+  MODIFY_REG(h->Instance->CR1, SPI_CR1_BR, nb << SPI_CR1_BR_Pos);
+  h->Init.BaudRatePrescaler = nb << SPI_CR1_BR_Pos;
+}
+
+static uint8_t can_switch(void){
+  return (uint8_t)(hspi1.State == HAL_SPI_STATE_READY && !(SPI1->SR & SPI_SR_BSY) &&
+                   !XPT_BurstBusy() && !I2CDMA_Busy());
+}
+
+/* ====== Switch ====== */
+/* A new prescaler value takes effect up to 16 AHB cycles after the write;
+   each CFGR read costs at least one. */
+static void settle(void){
+  for (uint32_t i = 0; i < 16u; i++) (void)RCC->CFGR;
+}
+
+/* HCLK and APB dividers are written separately, in the order that keeps
+ * both APB clocks at or below the slower of their two levels in between:
+ * AHB first when HCLK drops, APB first when it rises. Flash wait states go
+ * up before a faster HCLK and down after a slower one. */
+static void write_dividers(const Level_Cfg *from, const Level_Cfg *to){
+  const uint32_t ppre_m = RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2;
+  if (to->hpre < from->hpre){                   /* HPRE codes grow with the divider */
+    __HAL_FLASH_SET_LATENCY(to->latency);
+    while (__HAL_FLASH_GET_LATENCY() != to->latency) { }
+    MODIFY_REG(RCC->CFGR, ppre_m, to->ppre1 | to->ppre2);
+    settle();
+    MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, to->hpre);
+    settle();
+  } else {
+    MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, to->hpre);
+    settle();
+    MODIFY_REG(RCC->CFGR, ppre_m, to->ppre1 | to->ppre2);
+    settle();
+    __HAL_FLASH_SET_LATENCY(to->latency);
+  }
+  SystemCoreClockUpdate();
+}
+
+static void set_level(Clock_Level to){
+  if (to == lvl) return;
+  if (!can_switch()){ st.postponed++; return; }
+
+  Clocks a, b;
+  clocks_now(&a);
+
+  __disable_irq();
+  account();
+  uint32_t c0 = DWT->CYCCNT;
+  write_dividers(&lvl_cfg[lvl], &lvl_cfg[to]);
+  HAL_InitTick(uwTickPrio);                     /* TIM5 prescaler, count kept */
+  uint32_t c1 = DWT->CYCCNT;
+  clocks_now(&b);
+  tim_retime(TIM2, a.tim_apb1, b.tim_apb1, 0);  /* 4 kHz ADC trigger, soil excitation: TRGO */
+  tim_retime(TIM3, a.tim_apb1, b.tim_apb1, 0);  /* flow period tick: TRGO clocks TIM9 */
+  tim_retime(TIM4, a.tim_apb1, b.tim_apb1, 1);  /* servo 1 MHz tick */
+  tim_retime(TIM12, a.tim_apb1, b.tim_apb1, 1); /* buzzer 4.2 MHz tone tick */
+  spi_retime(&hspi1, a.pclk2, b.pclk2);         /* ILI9341 / XPT2046 */
+  I2CDMA_Init();                                /* TIM1 slot timing */
+  SWI2C_RecalcTiming();                         /* bit-bang delays in CPU cycles */
+  lvl     = to;
+  cur_mhz = b.hclk / 1000000u;
+  t_mark  = DWT->CYCCNT;
+  __enable_irq();
+
+  uint32_t us = (c1 - c0) / (a.hclk / 1000000u) + (t_mark - c1) / cur_mhz;
+  st.transitions++;
+  st.cost_last_us = us;
+  if (us > st.cost_max_us) st.cost_max_us = us;
+}
+
+/* ====== API ====== */
+void Clock_Init(void){
+  Cycles_Enable();
+  st      = (Clock_Stats){0};
+  holds   = 0;
+  lvl     = CLK_LVL_BOOST;
+  cur_mhz = HAL_RCC_GetHCLKFreq() / 1000000u;
+  t_mark  = DWT->CYCCNT;
+  for (uint32_t i = 0; i < CLK_LVL_COUNT; i++) res_us[i] = 0;
+}
+
+void Clock_Request(uint32_t who){
+  holds |= who;
+  set_level(CLK_LVL_BOOST);
+}
+
+void Clock_Release(uint32_t who){
+  holds &= ~who;
+}
+
+void Clock_IdlePoint(void){
+  account();
+  set_level(holds ? CLK_LVL_BOOST : CLK_LVL_IDLE);
+}
+
+Clock_Level Clock_Current(void){ return lvl; }
+
+void Clock_GetStats(Clock_Stats *out){
+  account();
+  st.level   = (uint8_t)lvl;
+  st.hclk_hz = cur_mhz * 1000000u;
+  for (uint32_t i = 0; i < CLK_LVL_COUNT; i++) st.res_ms[i] = (uint32_t)(res_us[i] / 1000u);
+  if (out) *out = st;
+}
@@ -0,0 +1,60 @@
+#include "deferred.h"
+#include "mpsc_ring.h"
+#include "cycles.h"
+
+typedef struct {
+  DeferFn  fn;
+  void    *arg;
+  uint32_t t_cyc;
+} Defer_Item;
+
+static MPSC_Ring  ring;                         /* producers: any priority, consumer: PendSV */
+static volatile uint32_t q_seq[DEFER_QUEUE_DEPTH];
+static Defer_Item q[DEFER_QUEUE_DEPTH];
+
+static Defer_Stats st;
+
+void Defer_Init(void){
+  Cycles_Enable();
+
+  MPSC_Init(&ring, q_seq, DEFER_QUEUE_DEPTH);
+  st = (Defer_Stats){0};
+  HAL_NVIC_SetPriority(PendSV_IRQn, 15, 0);
+}
+
+uint8_t Defer_Post(DeferFn fn, void *arg){
+  uint32_t pos;
+
+  if (!MPSC_Claim(&ring, &pos)){
+    MPSC_AtomicInc((volatile uint32_t *)&st.dropped);
+    return 0;
+  }
+  Defer_Item *s = &q[MPSC_Slot(&ring, pos)];
+  s->fn    = fn;
+  s->arg   = arg;
+  s->t_cyc = DWT->CYCCNT;
+  MPSC_Commit(&ring, pos);
+
+  MPSC_AtomicInc((volatile uint32_t *)&st.posted);
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+  return 1;
+}
+
+void Defer_Run(void){
+  uint32_t pos;
+  while (MPSC_Peek(&ring, &pos)){               /* stops when empty or a producer is mid-post (it re-pends) */
+    const Defer_Item *s = &q[MPSC_Slot(&ring, pos)];
+    DeferFn  fn  = s->fn;
+    void    *arg = s->arg;
+    uint32_t lat = DWT->CYCCNT - s->t_cyc;
+    MPSC_Release(&ring);
+
+    if (lat > st.lat_max) st.lat_max = lat;
+    fn(arg);
+    st.ran++;
+  }
+}
+
+void Defer_GetStats(Defer_Stats *out){
+  if (out) *out = st;
+}
@@ -0,0 +1,74 @@
+#include "encoder.h"
+#include "timebase.h"
+
+/* Speed -> step multiplier: detents per second at or above rate use mul */
+typedef struct { uint16_t rate; uint8_t mul; } Enc_Accel;
+static const Enc_Accel accel[] = {
+  { 40u, 10u },
+  { 20u,  4u },
+  {  8u,  2u },
+  {  0u,  1u },
+};
+
+static TIM_HandleTypeDef *enc_tim;
+static uint16_t last_cnt;
+static int32_t  rem;                          /* counts short of a detent */
+static uint32_t last_move_ms;
+
+static volatile uint8_t  presses;
+static TB_Timer          sw_tmr;              /* bounce window, restarted per edge */
+
+void Enc_Init(TIM_HandleTypeDef *htim){
+  enc_tim = htim;
+  HAL_TIM_Encoder_Start(htim, TIM_CHANNEL_ALL);
+  last_cnt     = (uint16_t)__HAL_TIM_GET_COUNTER(htim);
+  rem          = 0;
+  last_move_ms = HAL_GetTick();
+  presses      = 0;
+  TB_Stop(&sw_tmr);
+}
+
+int32_t Enc_Read(uint32_t now_ms){
+  if (!enc_tim) return 0;
+  uint16_t cnt = (uint16_t)__HAL_TIM_GET_COUNTER(enc_tim);
+  rem += (int16_t)(uint16_t)(cnt - last_cnt);   /* 16-bit wrap-safe */
+  last_cnt = cnt;
+
+  int32_t det = rem / ENC_COUNTS_PER_DETENT;
+  if (det == 0) return 0;
+  rem -= det * ENC_COUNTS_PER_DETENT;
+
+  uint32_t dt   = now_ms - last_move_ms;
+  uint32_t mag  = (uint32_t)(det < 0 ? -det : det);
+  uint32_t rate = dt ? (mag * 1000u) / dt : 1000u;
+  last_move_ms  = now_ms;
+
+  uint8_t mul = 1;
+  for (uint32_t i = 0; i < sizeof(accel) / sizeof(accel[0]); i++){
+    if (rate >= accel[i].rate){ mul = accel[i].mul; break; }
+  }
+  return det * mul;
+}
+
+uint8_t Enc_Clicked(void){
+  uint8_t hit = 0;
+  uint32_t pm = __get_PRIMASK();              /* callers may already have IRQs masked */
+  __disable_irq();
+  if (presses){ presses--; hit = 1; }
+  __set_PRIMASK(pm);
+  return hit;
+}
+
+/* Window expired with no further edge: the contact has settled. Low is a
+   press; high is the end of a release (its bounce restarted the window). */
+static void sw_settled(void *ctx){
+  (void)ctx;
+  if (HAL_GPIO_ReadPin(ENC_SW_GPIO_Port, ENC_SW_Pin) != GPIO_PIN_RESET) return;
+  if (presses < 255u) presses++;
+}
+
+/* Every falling edge, press or release bounce, restarts the window. */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+  if (GPIO_Pin != ENC_SW_Pin) return;
+  TB_Start(&sw_tmr, TB_Deadline(ENC_DEBOUNCE_US), 0, sw_settled, NULL);
+}
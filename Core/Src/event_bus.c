@@ -0,0 +1,70 @@
+#include "event_bus.h"
+#include "mpsc_ring.h"
+#include "cycles.h"
+
+static MPSC_Ring ring;                          /* producers: any context, consumer: main */
+static volatile uint32_t q_seq[EB_QUEUE_DEPTH];
+static Event    q[EB_QUEUE_DEPTH];
+
+typedef struct { EventHandler fn; void *ctx; } EB_Sub;
+static EB_Sub   subs[EVT_COUNT][EB_MAX_SUBS];
+static uint8_t  n_subs[EVT_COUNT];
+
+static EventBus_Stats st;
+
+void EventBus_Init(void){
+  Cycles_Enable();                              /* latency stamps */
+
+  MPSC_Init(&ring, q_seq, EB_QUEUE_DEPTH);
+  for (uint8_t t = 0; t < EVT_COUNT; t++) n_subs[t] = 0;
+  st = (EventBus_Stats){0};
+}
+
+uint8_t EventBus_Subscribe(EventType type, EventHandler fn, void *ctx){
+  if (type >= EVT_COUNT || !fn || n_subs[type] >= EB_MAX_SUBS) return 0;
+  subs[type][n_subs[type]].fn  = fn;
+  subs[type][n_subs[type]].ctx = ctx;
+  n_subs[type]++;
+  return 1;
+}
+
+uint8_t EventBus_Publish(EventType type, uint32_t value){
+  uint32_t t = DWT->CYCCNT;
+  uint32_t pos;
+
+  if (!MPSC_Claim(&ring, &pos)){                /* full: drop and count */
+    MPSC_AtomicInc((volatile uint32_t *)&st.dropped);
+    return 0;
+  }
+  Event *e = &q[MPSC_Slot(&ring, pos)];
+  e->type  = (uint8_t)type;
+  e->t_cyc = t;
+  e->v.u   = value;
+  MPSC_Commit(&ring, pos);
+
+  MPSC_AtomicInc((volatile uint32_t *)&st.published);
+  return 1;
+}
+
+uint16_t EventBus_Dispatch(void){
+  uint16_t n = 0;
+  uint32_t pos;
+  while (MPSC_Peek(&ring, &pos)){               /* stops when empty or a producer is mid-write */
+    Event ev = q[MPSC_Slot(&ring, pos)];
+    MPSC_Release(&ring);
+
+    uint32_t lat = DWT->CYCCNT - ev.t_cyc;
+    st.lat_last = lat;
+    if (lat > st.lat_max) st.lat_max = lat;
+
+    for (uint8_t i = 0; i < n_subs[ev.type]; i++)
+      subs[ev.type][i].fn(&ev, subs[ev.type][i].ctx);
+    st.dispatched++;
+    n++;
+  }
+  return n;
+}
+
+void EventBus_GetStats(EventBus_Stats *out){
+  if (out) *out = st;
+}
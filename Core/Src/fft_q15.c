@@ -0,0 +1,77 @@
+#include "fft_q15.h"
+#include <math.h>
+
+/* ---- Tables for the configured size ---- */
+static uint16_t fft_n = 0;                       /* real length N            */
+static uint16_t fft_m = 0;                       /* complex length M = N/2   */
+static cq15_t   tw[FFT_Q15_MAX_N / 2u];          /* W_N^k = e^{-j2πk/N}, k<M */
+
+static inline int16_t sat16(int32_t v){
+  return (int16_t)((v > 32767) ? 32767 : (v < -32768) ? -32768 : v);
+}
+
+/* (a*b) in q15 with rounding */
+static inline int32_t mul15(int32_t a, int32_t b){ return (a * b + 0x4000) >> 15; }
+
+int FFT_Q15_Init(uint16_t n){
+  if (n < 8u || n > FFT_Q15_MAX_N || (n & (n - 1u))) return 0;
+  fft_n = n;
+  fft_m = (uint16_t)(n / 2u);
+  for (uint16_t k = 0; k < fft_m; k++){
+    float a = -6.28318530718f * (float)k / (float)n;
+    tw[k].re = sat16((int32_t)lrintf(cosf(a) * 32767.0f));
+    tw[k].im = sat16((int32_t)lrintf(sinf(a) * 32767.0f));
+  }
+  return 1;
+}
+
+/* In-place complex FFT of length fft_m over cq15_t, 1/2 scaling per stage.
+ * Twiddles W_M^k = W_N^{2k}, so the N table serves with stride 2. */
+static void cfft(cq15_t *x){
+  const uint16_t m = fft_m;
+
+  /* bit-reverse permutation */
+  for (uint16_t i = 1, j = 0; i < m; i++){
+    uint16_t bit = m >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j){ cq15_t t = x[i]; x[i] = x[j]; x[j] = t; }
+  }
+
+  for (uint16_t len = 2, stride = m; len <= m; len <<= 1){
+    uint16_t half = len >> 1;
+    stride >>= 1;                                  /* W_M step for this stage */
+    for (uint16_t i = 0; i < m; i += len){
+      for (uint16_t k = 0; k < half; k++){
+        cq15_t w = tw[2u * k * stride];
+        cq15_t *a = &x[i + k], *b = &x[i + k + half];
+        int32_t br = mul15(b->re, w.re) - mul15(b->im, w.im);
+        int32_t bi = mul15(b->re, w.im) + mul15(b->im, w.re);
+        int32_t ar = a->re, ai = a->im;
+        a->re = (int16_t)((ar + br) >> 1);  a->im = (int16_t)((ai + bi) >> 1);
+        b->re = (int16_t)((ar - br) >> 1);  b->im = (int16_t)((ai - bi) >> 1);
+      }
+    }
+  }
+}
+
+void FFT_Q15_Real(cq15_t *z, cq15_t *out){
+  const uint16_t m = fft_m;
+  cfft(z);                                       /* z = x[2n] + j x[2n+1] in; Z / M out */
+
+  /* Split: X[k] = ½(Z[k] + Z*[M-k]) - ½j W_N^k (Z[k] - Z*[M-k]).
+   * With Z already /M this yields X/M, i.e. amplitude for a sine. */
+  for (uint16_t k = 0; k < m; k++){
+    cq15_t a = z[k];
+    cq15_t b = z[k ? (uint16_t)(m - k) : 0u];
+    int32_t er = ((int32_t)a.re + b.re) >> 1;    /* even part   */
+    int32_t ei = ((int32_t)a.im - b.im) >> 1;
+    int32_t or_ = ((int32_t)a.im + b.im) >> 1;   /* odd part, already * -j */
+    int32_t oi = ((int32_t)b.re - a.re) >> 1;
+    cq15_t w = tw[k];
+    int32_t tr = mul15(or_, w.re) - mul15(oi, w.im);
+    int32_t ti = mul15(or_, w.im) + mul15(oi, w.re);
+    out[k].re = sat16(er + tr);
+    out[k].im = sat16(ei + ti);
+  }
+}
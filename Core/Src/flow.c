@@ -0,0 +1,82 @@
+#include "flow.h"
+#include "tim.h"
+
+static Flow_Result res;
+static uint16_t last_cnt   = 0;                 /* TIM9 CNT at the previous call */
+static uint8_t  stall      = 1;                 /* CCR1 not a valid period yet */
+
+static uint8_t  last_demand = 0;
+static uint32_t t_change    = 0;
+static uint8_t  leak_armed  = 0;
+static uint32_t leak_base   = 0;                /* pulses when the no-demand window opened */
+
+static uint32_t pulses_to_ml(uint32_t p){
+  return (uint32_t)(((uint64_t)p * 1000u) / FLOW_PULSES_PER_L);
+}
+
+HAL_StatusTypeDef Flow_Start(void){
+  if (HAL_TIM_Base_Start(&htim9) != HAL_OK) return HAL_ERROR;
+  if (HAL_TIM_IC_Start(&htim3, TIM_CHANNEL_1) != HAL_OK) return HAL_ERROR;
+  __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+
+  last_cnt    = (uint16_t)__HAL_TIM_GET_COUNTER(&htim9);
+  stall       = 1;
+  res         = (Flow_Result){0};
+  last_demand = 0;
+  t_change    = HAL_GetTick();
+  leak_armed  = 0;
+  return HAL_OK;
+}
+
+void Flow_Process(uint32_t now_ms, uint8_t demand){
+  /* overflow first: a pulse after this read is caught on the next call */
+  uint8_t uif = (uint8_t)(__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE) != RESET);
+  if (uif) __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+
+  uint16_t cnt = (uint16_t)__HAL_TIM_GET_COUNTER(&htim9);
+  uint16_t n   = (uint16_t)(cnt - last_cnt);    /* wrap-safe, < 65536 per call */
+  last_cnt = cnt;
+  res.pulses   += n;
+  res.volume_ml = pulses_to_ml(res.pulses);
+
+  /* instantaneous flow from the hardware-latched period; after > 655 ms
+     without a pulse the next period has wrapped, so skip that one */
+  if (uif) stall = 1;
+  if (n){
+    if (stall) stall = 0;
+    else {
+      uint16_t per = (uint16_t)__HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_1);
+      res.period_ticks = per;
+      res.lpm_x10 = per ? (uint16_t)((FLOW_TICK_HZ * 600u) / ((uint32_t)per * FLOW_PULSES_PER_L)) : 0u;
+    }
+  }
+  if (stall) res.lpm_x10 = 0;
+
+  /* leak / blocked line, judged once the pipe has filled or drained */
+  if (demand != last_demand){
+    last_demand = demand;
+    t_change    = now_ms;
+    leak_armed  = 0;
+  }
+  uint8_t settled = (uint8_t)(now_ms - t_change >= FLOW_SETTLE_MS);
+
+  uint8_t st = res.status & FLOW_ST_LEAK;       /* leak latches until cleared */
+  if (res.lpm_x10) st |= FLOW_ST_FLOWING;
+
+  if (!demand && settled){
+    if (!leak_armed){ leak_armed = 1; leak_base = res.pulses; }
+    res.leak_ml = pulses_to_ml(res.pulses - leak_base);
+    if (res.leak_ml >= FLOW_LEAK_ML) st |= FLOW_ST_LEAK;
+  }
+  if (demand && settled && res.lpm_x10 < FLOW_MIN_LPM_X10) st |= FLOW_ST_BLOCKED;
+
+  res.status = st;
+}
+
+void Flow_Get(Flow_Result *out){ if (out) *out = res; }
+
+void Flow_ClearFaults(void){
+  res.status &= (uint8_t)~FLOW_ST_LEAK;
+  res.leak_ml = 0;
+  leak_armed  = 0;
+}
@@ -0,0 +1,85 @@
+#include "history.h"
+
+typedef struct { uint8_t lo, hi; } Hist_MM;   /* lo > hi: no data */
+
+/* 8-bit code = (value - offset) / step */
+static const float ch_off [HIST_CH_COUNT] = { -20.0f, 0.0f };
+static const float ch_step[HIST_CH_COUNT] = {   0.5f, 0.5f };
+
+/* Level k occupies HIST_DEPTH >> k entries starting at lvl_off(k) */
+#define PYR_SIZE  (2u * HIST_DEPTH - ((2u * HIST_DEPTH) >> HIST_LEVELS))
+static Hist_MM  pyr[HIST_CH_COUNT][PYR_SIZE];
+static Hist_MM  open_mm[HIST_CH_COUNT];
+static uint32_t count;                         /* base buckets closed */
+static uint8_t  minutes;                       /* in the open bucket  */
+
+static inline uint32_t lvl_off(uint32_t k){ return 2u * HIST_DEPTH - ((2u * HIST_DEPTH) >> k); }
+static inline Hist_MM *at(uint32_t ch, uint32_t k, uint32_t idx){
+  return &pyr[ch][lvl_off(k) + (idx & ((HIST_DEPTH >> k) - 1u))];
+}
+
+static const Hist_MM mm_empty = { 0xFF, 0x00 };
+
+static uint8_t encode(uint32_t ch, float v){
+  float c = (v - ch_off[ch]) / ch_step[ch] + 0.5f;
+  if (c < 0.0f)   return 0;
+  if (c > 254.0f) return 254;
+  return (uint8_t)c;
+}
+
+static void mm_merge(Hist_MM *a, const Hist_MM *b){
+  if (b->lo < a->lo) a->lo = b->lo;
+  if (b->hi > a->hi) a->hi = b->hi;
+}
+
+void Hist_Init(void){
+  for (uint32_t ch = 0; ch < HIST_CH_COUNT; ch++){
+    for (uint32_t i = 0; i < PYR_SIZE; i++) pyr[ch][i] = mm_empty;
+    open_mm[ch] = mm_empty;
+  }
+  count   = 0;
+  minutes = 0;
+}
+
+void Hist_AddMinute(Hist_Channel ch, float lo, float hi){
+  if (ch >= HIST_CH_COUNT) return;
+  Hist_MM m = { encode(ch, lo), encode(ch, hi) };
+  mm_merge(&open_mm[ch], &m);
+}
+
+/* Store the base bucket, then rebuild its ancestor at every level from
+   the (one or two) children that exist so far. */
+static void close_base(void){
+  uint32_t seq = count;
+  for (uint32_t ch = 0; ch < HIST_CH_COUNT; ch++){
+    *at(ch, 0, seq) = open_mm[ch];
+    open_mm[ch] = mm_empty;
+    for (uint32_t k = 1; k < HIST_LEVELS; k++){
+      uint32_t idx = seq >> k;
+      Hist_MM  m   = *at(ch, k - 1u, 2u * idx);
+      if ((2u * idx + 1u) <= (seq >> (k - 1u))) mm_merge(&m, at(ch, k - 1u, 2u * idx + 1u));
+      *at(ch, k, idx) = m;
+    }
+  }
+  count++;
+}
+
+uint8_t Hist_EndMinute(void){
+  if (++minutes < HIST_BASE_MIN) return 0;
+  minutes = 0;
+  close_base();
+  return 1;
+}
+
+uint32_t Hist_Count(void){ return count; }
+
+uint8_t Hist_Range(Hist_Channel ch, uint8_t level, uint32_t idx, float *lo, float *hi){
+  if (ch >= HIST_CH_COUNT || level >= HIST_LEVELS || count == 0u) return 0;
+  uint32_t newest = (count - 1u) >> level;
+  if (idx > newest || newest - idx >= (HIST_DEPTH >> level)) return 0;
+  const Hist_MM *m = at(ch, level, idx);
+  if (m->lo > m->hi) return 0;
+  *lo = ch_off[ch] + ch_step[ch] * (float)m->lo;
+  *hi = ch_off[ch] + ch_step[ch] * (float)m->hi;
+  return 1;
+}
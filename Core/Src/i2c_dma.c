@@ -0,0 +1,248 @@
+#include "i2c_dma.h"
+#include "i2c_trace.h"
+#include "i2c_sw.h"
+#include "tim.h"
+#include "bkp_sram.h"
+#include "timebase.h"
+
+extern DMA_HandleTypeDef hdma_tim1_up;
+extern DMA_HandleTypeDef hdma_tim1_ch1;
+
+/* ---- PB6=SCL, PB7=SDA (open-drain: set = release, reset = pull low) ---- */
+#define SCL_BIT   GPIO_PIN_6
+#define SDA_BIT   GPIO_PIN_7
+#define BSRR_WORD(scl, sda) \
+  (((scl) ? SCL_BIT : ((uint32_t)SCL_BIT << 16)) | ((sda) ? SDA_BIT : ((uint32_t)SDA_BIT << 16)))
+
+#define MAX_BYTES 12u     /* bytes on the wire per transaction (addr + reg + data) */
+
+/* ---- Program + capture buffers ----
+ * rx[k+1] holds the bus state during slot k: the first CC1 request comes
+ * one compare before the first UP request, so rx[0] is the idle bus. */
+static uint32_t tx[I2CDMA_MAX_SLOTS];
+static uint16_t rx[I2CDMA_MAX_SLOTS + 1U];
+static uint16_t n_slot;
+static uint8_t  cur_scl, cur_sda;
+
+static uint16_t ack_at[MAX_BYTES];     /* sample slot of each ACK bit we expect */
+static uint8_t  n_ack;
+static uint16_t rd_at[MAX_BYTES];      /* first sample slot of each byte we read */
+static uint8_t  n_rd;
+
+static uint8_t *rd_dst;
+static volatile uint8_t busy = 0;
+static I2CTrace_Entry *tr = NULL;
+
+/* ---- Program builder ---- */
+static inline void emit(uint8_t scl, uint8_t sda){
+  cur_scl = scl; cur_sda = sda;
+  tx[n_slot++] = BSRR_WORD(scl, sda);
+}
+
+/* One bit = 4 slots: data change with SCL low, 2 slots high, SCL falls.
+ * Returns the slot in which SDA is sampled (second high slot). */
+static uint16_t put_bit(uint8_t b){
+  emit(0, b);
+  emit(1, b);
+  emit(1, b);
+  uint16_t at = (uint16_t)(n_slot - 1U);
+  emit(0, b);
+  return at;
+}
+
+static void put_start(void){           /* also a repeated START */
+  if (cur_scl == 0){ emit(0, 1); emit(1, 1); }
+  else             { emit(1, 1); }
+  emit(1, 0);
+  emit(0, 0);
+}
+
+static void put_stop(void){
+  emit(0, 0);
+  emit(1, 0);
+  emit(1, 0);
+  emit(1, 1);
+}
+
+static void put_wr(uint8_t b){
+  for (int i=7;i>=0;i--) (void)put_bit((uint8_t)((b >> i) & 1U));
+  ack_at[n_ack++] = put_bit(1);         /* release SDA for the slave's ACK */
+}
+
+static void put_rd(uint8_t ack){
+  uint16_t first = 0;
+  for (int i=7;i>=0;i--){
+    uint16_t at = put_bit(1);
+    if (i == 7) first = at;
+  }
+  rd_at[n_rd++] = first;
+  (void)put_bit(ack ? 0 : 1);
+}
+
+static inline uint8_t sda_at(uint16_t slot){ return (rx[slot + 1U] & SDA_BIT) != 0; }
+
+/* ---- Slot timing ---- */
+static uint32_t tim1_clk(void){
+  uint32_t pclk2 = HAL_RCC_GetPCLK2Freq();
+  return ((RCC->CFGR & RCC_CFGR_PPRE2) == 0) ? pclk2 : 2U * pclk2;
+}
+
+void I2CDMA_Init(void){
+  uint32_t arr = (uint32_t)(((uint64_t)tim1_clk() * I2CDMA_SLOT_NS + 999999999ULL) / 1000000000ULL);
+  if (arr < 8U) arr = 8U;
+  __HAL_TIM_SET_AUTORELOAD(&htim1, arr - 1U);
+  __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, (arr * 3U) / 4U);  /* sample late in the slot */
+  cur_scl = cur_sda = 1;
+}
+
+/* ---- Engine ---- */
+static void xfer_done(DMA_HandleTypeDef *hdma){
+  (void)hdma;
+  __HAL_TIM_DISABLE(&htim1);
+  __HAL_TIM_DISABLE_DMA(&htim1, TIM_DMA_UPDATE | TIM_DMA_CC1);
+  (void)HAL_DMA_Abort(&hdma_tim1_up);   /* already complete: just returns it to READY */
+  busy = 0;
+}
+
+static void xfer_error(DMA_HandleTypeDef *hdma){
+  xfer_done(hdma);
+  n_ack = 0xFF;                          /* mark as failed for the decoder */
+}
+
+static HAL_StatusTypeDef run(void){
+  __HAL_TIM_DISABLE(&htim1);
+  __HAL_TIM_SET_COUNTER(&htim1, 0);
+
+  hdma_tim1_ch1.XferCpltCallback  = xfer_done;
+  hdma_tim1_ch1.XferErrorCallback = xfer_error;
+
+  if (HAL_DMA_Start(&hdma_tim1_up, (uint32_t)(uintptr_t)tx, (uint32_t)(uintptr_t)&GPIOB->BSRR, n_slot) != HAL_OK)
+    return HAL_ERROR;
+  if (HAL_DMA_Start_IT(&hdma_tim1_ch1, (uint32_t)(uintptr_t)&GPIOB->IDR, (uint32_t)(uintptr_t)rx, n_slot + 1U) != HAL_OK){
+    (void)HAL_DMA_Abort(&hdma_tim1_up);
+    return HAL_ERROR;
+  }
+
+  busy = 1;
+  __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE | TIM_FLAG_CC1);
+  __HAL_TIM_ENABLE_DMA(&htim1, TIM_DMA_UPDATE | TIM_DMA_CC1);
+  __HAL_TIM_ENABLE(&htim1);
+  return HAL_OK;
+}
+
+static void begin(uint8_t op, uint8_t addr8, uint8_t reg, uint16_t len, uint8_t *dst){
+  n_slot = 0; n_ack = 0; n_rd = 0;
+  cur_scl = cur_sda = 1;                 /* bus idle between transactions */
+  rd_dst = dst;
+#if I2C_TRACE_ENABLE
+  tr = I2CTrace_Begin(op, (uint8_t)(addr8 >> 1), reg, len, SWI2C_FAST);
+#else
+  (void)op; (void)addr8; (void)reg; (void)len;
+#endif
+}
+
+uint8_t I2CDMA_Busy(void){ return busy; }
+
+/* Decode ACKs and read bytes once the waveform has played. */
+static HAL_StatusTypeDef finish(void){
+  uint8_t ok = (n_ack != 0xFFU);
+  for (uint8_t i = 0; ok && i < n_ack; i++){
+    uint8_t ack = (uint8_t)!sda_at(ack_at[i]);
+#if I2C_TRACE_ENABLE
+    if (tr) tr->ack_mask |= (uint32_t)ack << tr->nbytes++;
+#endif
+    if (!ack) ok = 0;
+  }
+  if (ok && rd_dst){
+    for (uint8_t i = 0; i < n_rd; i++){
+      uint8_t v = 0;
+      for (uint8_t b = 0; b < 8U; b++) v = (uint8_t)((v << 1) | sda_at((uint16_t)(rd_at[i] + 4U * b)));
+      rd_dst[i] = v;
+    }
+  }
+#if I2C_TRACE_ENABLE
+  if (tr){ I2CTrace_End(tr, ok); tr = NULL; }
+#endif
+  rd_dst = NULL;
+  if (!ok) BKP_CountI2CError();
+  return ok ? HAL_OK : HAL_ERROR;
+}
+
+/* TIM1 stalled or a DMA completion went missing: stop both streams and
+   leave the pins released (the bus recovers like after a failed bit-bang
+   transfer). */
+static HAL_StatusTypeDef give_up(void){
+  __HAL_TIM_DISABLE(&htim1);
+  __HAL_TIM_DISABLE_DMA(&htim1, TIM_DMA_UPDATE | TIM_DMA_CC1);
+  (void)HAL_DMA_Abort(&hdma_tim1_up);
+  (void)HAL_DMA_Abort(&hdma_tim1_ch1);
+  GPIOB->BSRR = BSRR_WORD(1, 1);
+  cur_scl = cur_sda = 1;
+  busy    = 0;
+#if I2C_TRACE_ENABLE
+  if (tr){ I2CTrace_End(tr, 0); tr = NULL; }
+#endif
+  rd_dst = NULL;
+  BKP_CountI2CError();
+  return HAL_TIMEOUT;
+}
+
+static void wake_cb(void *ctx){ (void)ctx; }
+
+/* Sleep until the capture stream completes, at most twice the waveform
+   length; a timebase timer makes sure WFI returns at the deadline. */
+static HAL_StatusTypeDef wait_done(void){
+  static TB_Timer tmo;
+  uint32_t deadline = TB_Deadline(2U * n_slot * I2CDMA_SLOT_NS / 1000U + 1U);
+  TB_Start(&tmo, deadline, 0, wake_cb, NULL);
+  __disable_irq();
+  while (busy && !TB_Expired(deadline)){
+    __WFI();
+    __enable_irq();
+    __disable_irq();
+  }
+  __enable_irq();
+  TB_Stop(&tmo);
+  return busy ? give_up() : finish();
+}
+
+/* ---- Transactions ---- */
+HAL_StatusTypeDef I2CDMA_Mem_Read(uint8_t addr8, uint8_t mem, uint8_t *data, uint16_t len){
+  if (busy) return HAL_BUSY;
+  if (len == 0 || len > MAX_BYTES - 3U) return HAL_ERROR;
+  begin(I2CT_MEM_READ, addr8, mem, len, data);
+  put_start();
+  put_wr((uint8_t)(addr8 & ~1U));
+  put_wr(mem);
+  put_start();
+  put_wr((uint8_t)(addr8 | 1U));
+  for (uint16_t i=0;i<len;i++) put_rd(i < (len-1U));
+  put_stop();
+  if (run() != HAL_OK) return HAL_ERROR;
+  return wait_done();
+}
+
+HAL_StatusTypeDef I2CDMA_Read(uint8_t addr8, uint8_t *data, uint16_t len){
+  if (busy) return HAL_BUSY;
+  if (len == 0 || len > MAX_BYTES - 1U) return HAL_ERROR;
+  begin(I2CT_READ, addr8, 0, len, data);
+  put_start();
+  put_wr((uint8_t)(addr8 | 1U));
+  for (uint16_t i=0;i<len;i++) put_rd(i < (len-1U));
+  put_stop();
+  if (run() != HAL_OK) return HAL_ERROR;
+  return wait_done();
+}
+
+HAL_StatusTypeDef I2CDMA_Mem_Write(uint8_t addr8, uint8_t mem, const uint8_t *data, uint16_t len){
+  if (busy) return HAL_BUSY;
+  if (len > MAX_BYTES - 2U) return HAL_ERROR;
+  begin(I2CT_MEM_WRITE, addr8, mem, len, NULL);
+  put_start();
+  put_wr((uint8_t)(addr8 & ~1U));
+  put_wr(mem);
+  for (uint16_t i=0;i<len;i++) put_wr(data[i]);
+  put_stop();
+  if (run() != HAL_OK) return HAL_ERROR;
+  return wait_done();
+}
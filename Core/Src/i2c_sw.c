@@ -1,4 +1,7 @@
 #include "i2c_sw.h"
+#include "i2c_trace.h"
+#include "bkp_sram.h"
+#include "cycles.h"
 
 /* ---- PB6=SCL, PB7=SDA ---- */
 #define SW_SCL_GPIO   GPIOB
@@ -15,51 +18,108 @@ static inline void SDA_LO(void){ HAL_GPIO_WritePin(SW_SDA_GPIO, SW_SDA_PIN, GPIO
 static inline GPIO_PinState SDA_RD(void){ return HAL_GPIO_ReadPin(SW_SDA_GPIO, SW_SDA_PIN); }
 static inline GPIO_PinState SCL_RD(void){ return HAL_GPIO_ReadPin(SW_SCL_GPIO, SW_SCL_PIN); }
 
-/* precise µs delay — DWT->CYCCNT */
-static inline void delay_us(uint32_t us){
-  const uint32_t ticks = (SystemCoreClock/1000000U)*us;
+/* ---- Bus timing per speed profile (UM10204 table 10 minimums, ns) ---- */
+typedef struct { uint16_t low, high, su_sta, hd_sta, su_sto, buf; } swi2c_ns_t;
+static const swi2c_ns_t prof_ns[SWI2C_SPEED_COUNT] = {
+  [SWI2C_STD ] = { 4700, 4000, 4700, 4000, 4000, 4700 },
+  [SWI2C_FAST] = { 1300,  600,  600,  600,  600, 1300 },
+  [SWI2C_FMP ] = {  500,  260,  260,  260,  260,  500 },
+};
+
+/* Same phases in CPU cycles, rebuilt by SWI2C_RecalcTiming() */
+typedef struct { uint32_t lo_half, high, su_sta, hd_sta, su_sto, buf; } swi2c_cyc_t;
+static swi2c_cyc_t prof_cyc[SWI2C_SPEED_COUNT];
+static const swi2c_cyc_t *tm = &prof_cyc[SWI2C_STD];  /* active profile */
+static uint32_t stretch_cyc;                            /* clock-stretch timeout */
+
+static uint8_t dev_speed[128];                          /* per 7-bit address, 0 = STD */
+
+static uint32_t ns_to_cyc(uint32_t ns){
+  return (ns * (SystemCoreClock / 1000000U) + 999U) / 1000U;
+}
+
+void SWI2C_RecalcTiming(void){
+  for (int i=0;i<SWI2C_SPEED_COUNT;i++){
+    const swi2c_ns_t *n = &prof_ns[i];
+    swi2c_cyc_t *c = &prof_cyc[i];
+    c->lo_half = ns_to_cyc((n->low + 1U) / 2U);
+    c->high    = ns_to_cyc(n->high);
+    c->su_sta  = ns_to_cyc(n->su_sta);
+    c->hd_sta  = ns_to_cyc(n->hd_sta);
+    c->su_sto  = ns_to_cyc(n->su_sto);
+    c->buf     = ns_to_cyc(n->buf);
+  }
+  stretch_cyc = (SystemCoreClock / 1000000U) * 200U;
+}
+
+void SWI2C_SetDeviceSpeed(uint8_t addr7, SWI2C_Speed sp){
+  if (addr7 < 128U && sp < SWI2C_SPEED_COUNT) dev_speed[addr7] = (uint8_t)sp;
+}
+
+/* select the profile for this transaction's device */
+static inline void use_dev(uint8_t addr7){ tm = &prof_cyc[dev_speed[addr7 & 0x7FU]]; }
+
+/* ---- Trace hooks: entry of the transaction in flight (NULL = not tracing) ---- */
+#if I2C_TRACE_ENABLE
+static I2CTrace_Entry *tr = NULL;
+#define TR_BEGIN(op, a7, reg, len) (tr = I2CTrace_Begin((op), (a7), (reg), (len), dev_speed[(a7) & 0x7FU]))
+#define TR_END(ok)                 do { I2CTrace_End(tr, (ok)); tr = NULL; } while (0)
+#define TR_ACK(ack)                do { if (tr && tr->nbytes < 32U) tr->ack_mask |= (uint32_t)(ack) << tr->nbytes++; } while (0)
+#define TR_STRETCH(start, to)      do { if (tr){ tr->stretch_cyc += DWT->CYCCNT - (start); if (to) tr->flags |= I2CT_F_STRETCH_TO; } } while (0)
+#else
+#define TR_BEGIN(op, a7, reg, len) ((void)0)
+#define TR_END(ok)                 ((void)0)
+#define TR_ACK(ack)                ((void)0)
+#define TR_STRETCH(start, to)      ((void)0)
+#endif
+
+/* cycle-exact delay — DWT->CYCCNT, no per-call division */
+static inline void delay_cyc(uint32_t ticks){
   uint32_t start = DWT->CYCCNT;
   while ((DWT->CYCCNT - start) < ticks) { __NOP(); }
 }
 
-/* Wait for SCL release (clock stretching), timeout in µs */
-static inline int scl_release_wait(uint32_t tout_us){
+/* Wait for SCL release (clock stretching) */
+static inline int scl_release_wait(void){
   SCL_HI();
-  uint32_t start = DWT->CYCCNT, ticks = (SystemCoreClock/1000000U)*tout_us;
+  if (SCL_RD()==GPIO_PIN_SET) return 1;  /* not held: no timing work */
+  uint32_t start = DWT->CYCCNT;
   while (SCL_RD()==GPIO_PIN_RESET){
-    if ((DWT->CYCCNT - start) > ticks) return 0;
+    if ((DWT->CYCCNT - start) > stretch_cyc){ TR_STRETCH(start, 1); return 0; }
   }
+  TR_STRETCH(start, 0);
   return 1;
 }
 
 static void START(void){
-  SDA_HI(); SCL_HI(); delay_us(4);
-  SDA_LO(); delay_us(4);
-  SCL_LO(); delay_us(4);
+  SDA_HI(); SCL_HI(); delay_cyc(tm->su_sta);
+  SDA_LO(); delay_cyc(tm->hd_sta);
+  SCL_LO(); delay_cyc(tm->lo_half);
 }
 
 static void STOP(void){
-  SDA_LO(); delay_us(4);
-  (void)scl_release_wait(200);
-  delay_us(4);
-  SDA_HI(); delay_us(4);
+  SDA_LO(); delay_cyc(tm->lo_half);
+  (void)scl_release_wait();
+  delay_cyc(tm->su_sto);
+  SDA_HI(); delay_cyc(tm->buf);
 }
 
 /* Write byte; return 1 on ACK */
 static int WR(uint8_t b){
   for (int i=7;i>=0;i--){
     (b & (1U<<i)) ? SDA_HI() : SDA_LO();
-    delay_us(2);
-    if (!scl_release_wait(200)) return 0;
-    delay_us(3);
-    SCL_LO(); delay_us(2);
+    delay_cyc(tm->lo_half);
+    if (!scl_release_wait()) return 0;
+    delay_cyc(tm->high);
+    SCL_LO(); delay_cyc(tm->lo_half);
   }
   /* ACK bit from slave */
-  SDA_HI(); delay_us(2);                /* release */
-  if (!scl_release_wait(200)) return 0;
+  SDA_HI(); delay_cyc(tm->lo_half);     /* release */
+  if (!scl_release_wait()) return 0;
   int ack = (SDA_RD()==GPIO_PIN_RESET);
-  delay_us(3);
-  SCL_LO(); delay_us(2);
+  TR_ACK(ack);
+  delay_cyc(tm->high);
+  SCL_LO(); delay_cyc(tm->lo_half);
   return ack;
 }
 
@@ -68,16 +128,16 @@ static uint8_t RD(int ack){
   uint8_t v=0;
   SDA_HI();                              /* release for slave drive */
   for (int i=7;i>=0;i--){
-    if (!scl_release_wait(200)) break;
-    delay_us(2);
+    if (!scl_release_wait()) break;
+    delay_cyc(tm->high);
     if (SDA_RD()==GPIO_PIN_SET) v |= (uint8_t)(1U<<i);
-    SCL_LO(); delay_us(2);
+    SCL_LO(); delay_cyc(2U * tm->lo_half);
   }
   if (ack) SDA_LO(); else SDA_HI();
-  delay_us(2);
-  (void)scl_release_wait(200);
-  delay_us(3);
-  SCL_LO(); delay_us(2);
+  delay_cyc(tm->lo_half);
+  (void)scl_release_wait();
+  delay_cyc(tm->high);
+  SCL_LO(); delay_cyc(tm->lo_half);
   SDA_HI();
   return v;
 }
@@ -85,10 +145,8 @@ static uint8_t RD(int ack){
 void SWI2C_Init_PB6_PB7(void){
   __HAL_RCC_GPIOB_CLK_ENABLE();
 
-  /* Enable DWT CYCCNT */
-  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
-  DWT->CYCCNT = 0;
-  DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+  Cycles_Enable();                               /* DWT CYCCNT for bit timing */
+  SWI2C_RecalcTiming();
 
   GPIO_InitTypeDef g = {0};
   g.Mode  = GPIO_MODE_OUTPUT_OD;
@@ -98,22 +156,23 @@ void SWI2C_Init_PB6_PB7(void){
   g.Pin = SW_SCL_PIN; HAL_GPIO_Init(SW_SCL_GPIO, &g);
   g.Pin = SW_SDA_PIN; HAL_GPIO_Init(SW_SDA_GPIO, &g);
 
-  SCL_HI(); SDA_HI(); delay_us(5);      /* idle-high */
+  SCL_HI(); SDA_HI(); delay_cyc(prof_cyc[SWI2C_STD].buf);  /* idle-high */
 }
 
 /* UM10204 §3.1.16: up to 9 clocks if SDA stuck low */
 void SWI2C_BusClear(void){
+  tm = &prof_cyc[SWI2C_STD];            /* recovery always at 100 kHz */
   if (SDA_RD()==GPIO_PIN_RESET){
     for (int i=0;i<9;i++){
-      SCL_LO(); delay_us(5);
-      SCL_HI(); delay_us(5);
+      SCL_LO(); delay_cyc(tm->buf);
+      SCL_HI(); delay_cyc(tm->buf);
       if (SDA_RD()==GPIO_PIN_SET) break;
     }
   }
   STOP();
 }
 
-HAL_StatusTypeDef SWI2C_Mem_Read(uint8_t addr8, uint8_t mem, uint8_t *data, uint16_t len){
+static HAL_StatusTypeDef mem_read(uint8_t addr8, uint8_t mem, uint8_t *data, uint16_t len){
   START();
   if (!WR((uint8_t)(addr8 & ~1U))) { STOP(); return HAL_ERROR; }
   if (!WR(mem))                    { STOP(); return HAL_ERROR; }
@@ -126,7 +185,7 @@ HAL_StatusTypeDef SWI2C_Mem_Read(uint8_t addr8, uint8_t mem, uint8_t *data, uint
   return HAL_OK;
 }
 
-HAL_StatusTypeDef SWI2C_Mem_Write(uint8_t addr8, uint8_t mem, const uint8_t *data, uint16_t len){
+static HAL_StatusTypeDef mem_write(uint8_t addr8, uint8_t mem, const uint8_t *data, uint16_t len){
   START();
   if (!WR((uint8_t)(addr8 & ~1U))) { STOP(); return HAL_ERROR; }
   if (!WR(mem))                    { STOP(); return HAL_ERROR; }
@@ -137,10 +196,55 @@ HAL_StatusTypeDef SWI2C_Mem_Write(uint8_t addr8, uint8_t mem, const uint8_t *dat
   return HAL_OK;
 }
 
+static HAL_StatusTypeDef plain_read(uint8_t addr8, uint8_t *data, uint16_t len){
+  START();
+  if (!WR((uint8_t)(addr8 | 1U)))  { STOP(); return HAL_ERROR; }
+  for (uint16_t i=0;i<len;i++){
+    data[i] = RD((i < (len-1)) ? 1 : 0);
+  }
+  STOP();
+  return HAL_OK;
+}
+
+/* ---- Public transactions: select profile, trace, run ---- */
+HAL_StatusTypeDef SWI2C_Mem_Read(uint8_t addr8, uint8_t mem, uint8_t *data, uint16_t len){
+  uint8_t a7 = (uint8_t)(addr8 >> 1);
+  use_dev(a7);
+  TR_BEGIN(I2CT_MEM_READ, a7, mem, len);
+  HAL_StatusTypeDef st = mem_read(addr8, mem, data, len);
+  TR_END(st == HAL_OK);
+  if (st != HAL_OK) BKP_CountI2CError();
+  return st;
+}
+
+HAL_StatusTypeDef SWI2C_Mem_Write(uint8_t addr8, uint8_t mem, const uint8_t *data, uint16_t len){
+  uint8_t a7 = (uint8_t)(addr8 >> 1);
+  use_dev(a7);
+  TR_BEGIN(I2CT_MEM_WRITE, a7, mem, len);
+  HAL_StatusTypeDef st = mem_write(addr8, mem, data, len);
+  TR_END(st == HAL_OK);
+  if (st != HAL_OK) BKP_CountI2CError();
+  return st;
+}
+
+/* Plain read from the device's current register pointer (no mem phase) */
+HAL_StatusTypeDef SWI2C_Read(uint8_t addr8, uint8_t *data, uint16_t len){
+  uint8_t a7 = (uint8_t)(addr8 >> 1);
+  use_dev(a7);
+  TR_BEGIN(I2CT_READ, a7, 0, len);
+  HAL_StatusTypeDef st = plain_read(addr8, data, len);
+  TR_END(st == HAL_OK);
+  if (st != HAL_OK) BKP_CountI2CError();
+  return st;
+}
+
 uint8_t SWI2C_Scan_One(uint8_t addr7){
   uint8_t ok=0;
+  use_dev(addr7);
+  TR_BEGIN(I2CT_SCAN, addr7, 0, 0);
   START();
   if (WR((uint8_t)(addr7<<1))) ok=1;
   STOP();
+  TR_END(ok);
   return ok;
 }
@@ -0,0 +1,59 @@
+#include "i2c_trace.h"
+#include "integrity.h"
+#include <stdio.h>
+
+/* ====== Storage ====== */
+static I2CTrace_Entry it_buf[I2C_TRACE_DEPTH];
+static uint32_t it_total = 0;
+static uint32_t it_fail  = 0;
+
+I2CTrace_Entry *I2CTrace_Begin(uint8_t op, uint8_t addr7, uint8_t reg, uint16_t len, uint8_t speed){
+  I2CTrace_Entry *e = &it_buf[it_total & (I2C_TRACE_DEPTH - 1U)];
+  e->t_start     = DWT->CYCCNT;
+  e->ack_mask    = 0;
+  e->stretch_cyc = 0;
+  e->len   = len;
+  e->op    = op;    e->addr7  = addr7;
+  e->reg   = reg;   e->nbytes = 0;
+  e->flags = 0;     e->speed  = speed;
+  return e;
+}
+
+void I2CTrace_End(I2CTrace_Entry *e, uint8_t ok){
+  e->t_end = DWT->CYCCNT;
+  if (!ok){ e->flags |= I2CT_F_FAIL; it_fail++; }
+  it_total++;                                /* publish only when complete */
+}
+
+uint32_t I2CTrace_Total(void)   { return it_total; }
+uint32_t I2CTrace_Failures(void){ return it_fail;  }
+
+const I2CTrace_Entry *I2CTrace_Recent(uint16_t back){
+  if (back >= I2C_TRACE_DEPTH || back >= it_total) return NULL;
+  return &it_buf[(it_total - 1U - back) & (I2C_TRACE_DEPTH - 1U)];
+}
+
+void I2CTrace_Dump(void){
+  static const char *const op_name[] = { "MR", "MW", "RD", "SC" };
+  uint32_t n = (it_total < I2C_TRACE_DEPTH) ? it_total : I2C_TRACE_DEPTH;
+
+  printf("# i2c-trace v2 total=%lu fail=%lu cpu_hz=%lu\r\n",
+         (unsigned long)it_total, (unsigned long)it_fail, (unsigned long)SystemCoreClock);
+  char line[96];
+  Integrity_Stream crc;                          /* over every line after the '#' header */
+  Integrity_StreamBegin(&crc);
+  int len = snprintf(line, sizeof(line), "n,op,addr,reg,len,speed,t_start,cycles,ack_mask,nbytes,stretch,flags\r\n");
+  Integrity_StreamFeed(&crc, line, (uint32_t)len);
+  fputs(line, stdout);
+  for (uint32_t k = n; k > 0; k--){
+    const I2CTrace_Entry *e = I2CTrace_Recent((uint16_t)(k - 1U));
+    len = snprintf(line, sizeof(line), "%lu,%s,0x%02X,0x%02X,%u,%u,%lu,%lu,0x%08lX,%u,%lu,%u\r\n",
+                   (unsigned long)(it_total - k), op_name[e->op & 3U], e->addr7, e->reg,
+                   e->len, e->speed, (unsigned long)e->t_start,
+                   (unsigned long)(e->t_end - e->t_start), (unsigned long)e->ack_mask,
+                   e->nbytes, (unsigned long)e->stretch_cyc, e->flags);
+    Integrity_StreamFeed(&crc, line, (uint32_t)len);
+    fputs(line, stdout);
+  }
+  printf("# crc32=%08lX\r\n", (unsigned long)Integrity_StreamEnd(&crc));
+}
@@ -0,0 +1,161 @@
+#include "integrity.h"
+#include "dma.h"
+#include "cycles.h"
+#include <stdio.h>
+
+/* ====== Peripheral ====== */
+static volatile uint32_t hw_owned = 0;          /* CRC unit claimed (LDREX/STREX)  */
+static volatile uint8_t  dma_busy = 0;          /* DMA job in flight               */
+static uint8_t           dma_job  = 0;          /* Start succeeded, Result pending */
+static const uint8_t    *dma_tail = NULL;       /* bytes after the DMA'd words     */
+static uint32_t          dma_tail_n = 0;
+
+static void dma_done(DMA_HandleTypeDef *h){ (void)h; dma_busy = 0; }
+
+static uint8_t hw_claim(void){
+  do {
+    if (__LDREXW(&hw_owned)){ __CLREX(); return 0; }
+  } while (__STREXW(1u, &hw_owned));
+  __DMB();
+  return 1;
+}
+
+static void hw_release(void){
+  __DMB();
+  hw_owned = 0;
+}
+
+void Integrity_Init(void){
+  __HAL_RCC_CRC_CLK_ENABLE();
+  Integrity_RefInit();
+  hdma_memtomem_dma2_stream6.XferCpltCallback  = dma_done;
+  hdma_memtomem_dma2_stream6.XferErrorCallback = dma_done;
+}
+
+static uint32_t hw_words(const uint8_t *p, uint32_t nw){
+  CRC->CR = CRC_CR_RESET;
+  while (nw--){ CRC->DR = __UNALIGNED_UINT32_READ(p); p += 4; }
+  return CRC->DR;
+}
+
+uint32_t Integrity_CRC32(const void *data, uint32_t len){
+  if (!hw_claim()) return Integrity_CRC32_SW(INTEGRITY_CRC32_INIT, data, len);
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t crc = hw_words(p, len / 4u);
+  hw_release();
+  return Integrity_CRC32_SW(crc, p + (len & ~3u), len & 3u);   /* tail only */
+}
+
+uint32_t Integrity_CRC32_Force(const void *data, uint32_t len){
+  if (dma_busy){                                /* abandon the job, the MCU resets anyway */
+    DMA2_Stream6->CR &= ~(uint32_t)DMA_SxCR_EN;
+    while (DMA2_Stream6->CR & DMA_SxCR_EN) { }
+    dma_busy = 0;
+  }
+  hw_owned = 1;
+  const uint8_t *p = (const uint8_t *)data;
+  return Integrity_CRC32_SW(hw_words(p, len / 4u), p + (len & ~3u), len & 3u);
+}
+
+HAL_StatusTypeDef Integrity_CRC32_Start(const void *data, uint32_t len){
+  if (((uint32_t)(uintptr_t)data & 3u) || len < INTEGRITY_DMA_MIN) return HAL_ERROR;
+  if (!hw_claim()) return HAL_BUSY;
+
+  dma_tail   = (const uint8_t *)data + (len & ~3u);
+  dma_tail_n = len & 3u;
+  CRC->CR  = CRC_CR_RESET;
+  dma_busy = 1;
+  if (HAL_DMA_Start_IT(&hdma_memtomem_dma2_stream6, (uint32_t)(uintptr_t)data,
+                       (uint32_t)(uintptr_t)&CRC->DR, len / 4u) != HAL_OK){
+    dma_busy = 0;
+    hw_release();
+    return HAL_ERROR;
+  }
+  dma_job = 1;
+  return HAL_OK;
+}
+
+uint8_t Integrity_CRC32_Busy(void){ return dma_busy; }
+
+uint32_t Integrity_CRC32_Result(void){
+  if (!dma_job) return 0u;                      /* no job started */
+  __disable_irq();
+  while (dma_busy){
+    __WFI();
+    __enable_irq();
+    __disable_irq();
+  }
+  __enable_irq();
+  uint32_t crc = CRC->DR;
+  dma_job = 0;
+  hw_release();
+  return Integrity_CRC32_SW(crc, dma_tail, dma_tail_n);
+}
+
+/* ====== Streams ====== */
+void Integrity_StreamBegin(Integrity_Stream *s){
+  s->crc  = INTEGRITY_CRC32_INIT;
+  s->word = 0;
+  s->n    = 0;
+  s->hw   = hw_claim();
+  if (s->hw) CRC->CR = CRC_CR_RESET;
+}
+
+void Integrity_StreamFeed(Integrity_Stream *s, const void *data, uint32_t len){
+  const uint8_t *p = (const uint8_t *)data;
+  while (len--){
+    s->word |= (uint32_t)*p++ << (8u * s->n);   /* memory order of a LE word */
+    if (++s->n < 4u) continue;
+    if (s->hw) CRC->DR = s->word;
+    else       s->crc  = Integrity_CRC32_SW(s->crc, &s->word, 4u);
+    s->word = 0;
+    s->n    = 0;
+  }
+}
+
+uint32_t Integrity_StreamEnd(Integrity_Stream *s){
+  uint32_t crc = s->hw ? CRC->DR : s->crc;
+  if (s->hw){ hw_release(); s->hw = 0; }
+  return Integrity_CRC32_SW(crc, &s->word, s->n);      /* 0..3 trailing bytes */
+}
+
+/* ====== Self-test + throughput ====== */
+uint8_t Integrity_SelfTest(Integrity_Bench *out){
+  static uint32_t pat[257];                     /* 1028 B, word aligned */
+  const uint32_t len = 1027u;                   /* exercises the 3-byte tail */
+  uint32_t x = 0x12345678u;
+  for (uint32_t i = 0; i < 257u; i++){ x = x * 1664525u + 1013904223u; pat[i] = x; }
+
+  Cycles_Enable();
+
+  uint32_t t0 = DWT->CYCCNT;
+  uint32_t c_hw = Integrity_CRC32(pat, len);
+  uint32_t t1 = DWT->CYCCNT;
+  uint32_t c_dma = 0;
+  uint8_t  dma_ok = (Integrity_CRC32_Start(pat, len) == HAL_OK);
+  if (dma_ok) c_dma = Integrity_CRC32_Result();
+  uint32_t t2 = DWT->CYCCNT;
+  uint32_t c_sw = Integrity_CRC32_SW(INTEGRITY_CRC32_INIT, pat, len);
+  uint32_t t3 = DWT->CYCCNT;
+
+  Integrity_Stream s;                           /* odd chunks: words straddle feeds */
+  Integrity_StreamBegin(&s);
+  for (uint32_t o = 0; o < len; o += 7u)
+    Integrity_StreamFeed(&s, (const uint8_t *)pat + o, (len - o < 7u) ? len - o : 7u);
+  uint32_t c_st = Integrity_StreamEnd(&s);
+
+  uint8_t ok = (uint8_t)(c_hw == c_sw && (!dma_ok || c_dma == c_sw) && c_st == c_sw &&
+                         Integrity_CRC16(INTEGRITY_CRC16_INIT, "123456789", 9) == 0x29B1u);
+
+  Integrity_Bench b;
+  b.bytes    = len;
+  b.hw_bpkc  = (t1 - t0) ? len * 1000u / (t1 - t0) : 0u;
+  b.dma_bpkc = (dma_ok && t2 - t1) ? len * 1000u / (t2 - t1) : 0u;
+  b.sw_bpkc  = (t3 - t2) ? len * 1000u / (t3 - t2) : 0u;
+  if (out) *out = b;
+
+  printf("# crc selftest %s hw=%08lX dma=%08lX sw=%08lX B/kcyc hw=%lu dma=%lu sw=%lu\r\n",
+         ok ? "ok" : "FAIL", (unsigned long)c_hw, (unsigned long)c_dma, (unsigned long)c_sw,
+         (unsigned long)b.hw_bpkc, (unsigned long)b.dma_bpkc, (unsigned long)b.sw_bpkc);
+  return ok;
+}
@@ -0,0 +1,46 @@
+#include "integrity_ref.h"
+#include <string.h>
+
+static uint32_t tab32[256];
+static uint8_t  tab_ok = 0;
+
+void Integrity_RefInit(void){
+  for (uint32_t i = 0; i < 256u; i++){
+    uint32_t c = i << 24;
+    for (uint8_t b = 0; b < 8u; b++) c = (c & 0x80000000u) ? (c << 1) ^ 0x04C11DB7u : (c << 1);
+    tab32[i] = c;
+  }
+  tab_ok = 1;
+}
+
+static inline uint32_t sw_byte(uint32_t crc, uint8_t b){
+  return (crc << 8) ^ tab32[(crc >> 24) ^ b];
+}
+
+uint32_t Integrity_CRC32_SW(uint32_t crc, const void *data, uint32_t len){
+  if (!tab_ok) Integrity_RefInit();
+  const uint8_t *p = (const uint8_t *)data;
+  for (uint32_t n = len / 4u; n; n--, p += 4){
+    uint32_t w;
+    memcpy(&w, p, 4u);                            /* same word the peripheral sees (LE) */
+    crc = sw_byte(crc, (uint8_t)(w >> 24));
+    crc = sw_byte(crc, (uint8_t)(w >> 16));
+    crc = sw_byte(crc, (uint8_t)(w >> 8));
+    crc = sw_byte(crc, (uint8_t)w);
+  }
+  for (uint32_t n = len & 3u; n; n--) crc = sw_byte(crc, *p++);
+  return crc;
+}
+
+uint16_t Integrity_CRC16(uint16_t crc, const void *data, uint32_t len){
+  static const uint16_t nib[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF };
+  const uint8_t *p = (const uint8_t *)data;
+  while (len--){
+    uint8_t b = *p++;
+    crc = (uint16_t)((crc << 4) ^ nib[(crc >> 12) ^ (b >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ nib[(crc >> 12) ^ (b & 0x0Fu)]);
+  }
+  return crc;
+}
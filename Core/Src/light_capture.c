@@ -0,0 +1,132 @@
+#include "light_capture.h"
+#include "fft_q15.h"
+#include "adc.h"
+#include "tim.h"
+#include "event_bus.h"
+#include "cycles.h"
+#include <math.h>
+
+/* ====== Buffers ====== */
+static uint16_t dma_buf[2u * LIGHT_N];          /* ping-pong, filled by DMA2 S4 */
+static cq15_t   work[LIGHT_N / 2u];             /* windowed q15 as x[2i] + j x[2i+1], FFT work area */
+static cq15_t   bins[LIGHT_N / 2u];
+static int16_t  hann[LIGHT_N / 2u];             /* symmetric: first half only */
+
+static volatile uint8_t  ready_half = 0xFF;     /* 0/1 = half waiting, 0xFF = none */
+static volatile uint32_t half_seq   = 0;        /* DMA half/full events */
+static volatile uint32_t missed     = 0;        /* ISR only: halves never picked up */
+static uint32_t torn    = 0;                    /* main only: halves overwritten while copied */
+static uint8_t  running = 0;
+static uint8_t  tables  = 0;
+
+static LightCap_Result res;
+static uint8_t  have_res = 0;
+
+/* ====== DMA half/full (ADC1 regular group, routed from adc.c) ====== */
+void LightCap_OnDma(uint8_t half){
+  if (ready_half != 0xFF) missed++;            /* previous half never picked up */
+  ready_half = half; half_seq++;
+  EventBus_Publish(EVT_LIGHT_BLOCK, half);
+}
+
+/* ====== Control ====== */
+HAL_StatusTypeDef LightCap_Start(void){
+  if (running) return HAL_OK;
+  if (!tables){
+    if (!FFT_Q15_Init(LIGHT_N)) return HAL_ERROR;
+    for (uint16_t i = 0; i < LIGHT_N / 2u; i++)
+      hann[i] = (int16_t)lrintf(32767.0f * 0.5f * (1.0f - cosf(6.28318530718f * (float)i / (float)(LIGHT_N - 1u))));
+    tables = 1;
+  }
+  Cycles_Enable();                               /* cycle budget accounting */
+
+  ready_half = 0xFF;
+  if (HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dma_buf, 2u * LIGHT_N) != HAL_OK) return HAL_ERROR;
+  if (HAL_TIM_Base_Start(&htim2) != HAL_OK){ HAL_ADC_Stop_DMA(&hadc1); return HAL_ERROR; }
+  running = 1;
+  return HAL_OK;
+}
+
+void LightCap_Stop(void){
+  if (!running) return;
+  HAL_TIM_Base_Stop(&htim2);
+  HAL_ADC_Stop_DMA(&hadc1);
+  running = 0;
+  ready_half = 0xFF;
+}
+
+uint8_t LightCap_Running(void){ return running; }
+
+uint8_t LightCap_Get(LightCap_Result *out){
+  if (!have_res) return 0;
+  if (out){ *out = res; out->overruns = missed + torn; }
+  return 1;
+}
+
+/* ====== Block processing ====== */
+uint8_t LightCap_Process(void){
+  if (ready_half == 0xFF) return 0;
+
+  uint32_t t0  = DWT->CYCCNT;
+  uint32_t seq = half_seq;
+  const uint16_t *src = &dma_buf[ready_half ? LIGHT_N : 0u];
+  ready_half = 0xFF;
+
+  /* pass 1: DC, min/max */
+  uint32_t sum = 0; uint16_t mn = 0xFFFF, mx = 0;
+  for (uint16_t i = 0; i < LIGHT_N; i++){
+    uint16_t v = src[i];
+    sum += v;
+    if (v < mn) mn = v;
+    if (v > mx) mx = v;
+  }
+  int32_t dc = (int32_t)(sum / LIGHT_N);
+
+  /* pass 2: remove DC, scale 12 -> 15 bit, Hann window; even samples to
+     .re, odd to .im (the packing FFT_Q15_Real expects) */
+  for (uint16_t i = 0; i < LIGHT_N; i += 2u){
+    int32_t s0 = ((int32_t)src[i]      - dc) << 3;
+    int32_t s1 = ((int32_t)src[i + 1u] - dc) << 3;
+    int16_t w0 = hann[(i      < LIGHT_N / 2u) ? i      : (LIGHT_N - 1u - i)];
+    int16_t w1 = hann[(i + 1u < LIGHT_N / 2u) ? i + 1u : (LIGHT_N - 2u - i)];
+    work[i >> 1].re = (int16_t)((s0 * w0) >> 15);
+    work[i >> 1].im = (int16_t)((s1 * w1) >> 15);
+  }
+
+  /* The other half finished while we were copying: ours may be torn. */
+  if (half_seq != seq){ torn++; return 0; }
+
+  FFT_Q15_Real(work, bins);
+
+  /* dominant AC bin (skip DC and bin 1, which hold window/DC leakage) */
+  uint16_t kpk = 2; uint32_t ppk = 0;
+  for (uint16_t k = 2; k < LIGHT_N / 2u; k++){
+    uint32_t p = FFT_Q15_Mag2(bins[k]);
+    if (p > ppk){ ppk = p; kpk = k; }
+  }
+
+  /* parabolic interpolation on magnitudes around the peak */
+  float m0 = sqrtf((float)FFT_Q15_Mag2(bins[kpk - 1u]));
+  float m1 = sqrtf((float)ppk);
+  float m2 = (kpk + 1u < LIGHT_N / 2u) ? sqrtf((float)FFT_Q15_Mag2(bins[kpk + 1u])) : 0.0f;
+  float den = m0 - 2.0f * m1 + m2;
+  float dk  = (den != 0.0f) ? 0.5f * (m0 - m2) / den : 0.0f;
+  float hz  = ((float)kpk + dk) * (float)LIGHT_FS_HZ / (float)LIGHT_N;
+
+  /* amplitude: undo <<3 and the Hann coherent gain (0.5) */
+  res.peak_amp    = (uint16_t)(m1 * 2.0f / 8.0f + 0.5f);
+  res.peak_hz_x10 = (uint16_t)(hz * 10.0f + 0.5f);
+  res.dc_raw      = (uint16_t)dc;
+  res.flicker_pct = (mx + mn) ? (uint8_t)(((uint32_t)(mx - mn) * 100u) / (uint32_t)(mx + mn)) : 0u;
+
+  uint32_t f = (uint32_t)(hz + 0.5f);
+  uint8_t near_mains = (f + LIGHT_MAINS_TOL_HZ >= 100u && f <= 100u + LIGHT_MAINS_TOL_HZ) ||
+                       (f + LIGHT_MAINS_TOL_HZ >= 120u && f <= 120u + LIGHT_MAINS_TOL_HZ);
+  res.artificial  = (uint8_t)(near_mains && res.flicker_pct >= LIGHT_FLICKER_MIN_PCT);
+
+  res.blocks++;
+  res.cycles = DWT->CYCCNT - t0;
+  if (res.cycles > res.cycles_max) res.cycles_max = res.cycles;
+  have_res = 1;
+  return 1;
+}
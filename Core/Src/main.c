@@ -7,26 +7,60 @@
  * - I2C (software bit-bang on PB6/PB7) for DS1307 + LM75
  * - SPI for ILI9341 TFT + XPT2046 touch
  * - ADC (PC0 / IN10) for light sensor
- * - PWM (TIM4 CH3 / PB8) for MG90S servo
- * - Relay control on PB12
+ * - ADC2 (PC1..PC3) soil probes, excitation on PB10/PB11 (TIM2)
+ * - PWM (TIM4 CH3 / PB8) for MG90S servo, feedback pot on PC4 (ADC1 IN14, injected)
+ * - Relay / valve zones on PB12, PB5, PB15, PB9 (staggered turn-on)
+ * - Flow meter on PB4 (TIM3 period capture, TIM9 pulse count)
+ * - USB CDC (OTG FS, PA11/PA12): console mirror + 1 Hz telemetry lines
  * - GUI with 3 screens: STARTUP, CHECK, SETUP, PROJECT
- * - Time editing in SETUP and commit back to DS1307
+ * - On-chip RTC (LSE) calendar, DS1307 as boot seed + hourly drift check
+ * - Time editing in SETUP and commit to both clocks
+ * - Dynamic HCLK scaling: 42 MHz idle, 168 MHz for render / FFT bursts
+ * - 1 MHz 32/64-bit timebase on TIM5 (HAL tick, compare-match timers, no SysTick)
+ * - Streaming sensor statistics with minute / hour / day rollups
+ * - HISTORY chart (from PROJECT): temp/light min/max over 68 h, zoom + pan
+ * - Rotary encoder (TIM8 PC6/PC7) + select button (PC8 EXTI) as touch alternative
+ * - Buzzer on PB14 (TIM12 CH1 PWM tone sequencer): key clicks, irrigation start, flow alarm
  */
 
 #include "main.h"                  // Core HAL definitions and project-level declarations
 #include "spi.h"                   // SPI peripheral configuration header
 #include "gpio.h"                  // GPIO initialization utilities
 #include "adc.h"                   // ADC peripheral configuration header
+#include "dma.h"                   // DMA controller configuration header
 #include "tim.h"                   // Timer peripheral configuration header
 
 #include "ili9341.h"               // ILI9341 TFT driver API
 #include "xpt2046.h"               // XPT2046 touch controller driver API
 #include "i2c_sw.h"                // Software I2C bit-bang interface
+#include "i2c_trace.h"             // I2C transaction trace ring
+#include "i2c_dma.h"               // Timer+DMA I2C waveform engine
+#include "light_capture.h"         // High-rate light capture + flicker FFT
+#include "soil.h"                  // Soil moisture probes (ADC2 scan, AC excitation)
+#include "relay_zones.h"           // Relay/valve zone outputs (atomic BSRR, inrush stagger)
+#include "flow.h"                  // Hardware-counted flow meter
+#include "event_bus.h"             // ISR -> main loop publish/subscribe
+#include "deferred.h"              // PendSV bottom halves for ISRs
+#include "adc_inject.h"            // On-demand ADC1 injected conversions
+#include "bkp_sram.h"              // Persistent counters + fault snapshot
+#include "integrity.h"             // CRC32 (hardware) / CRC16 checksums
 #include "rtc_ds1307.h"            // DS1307 RTC driver
+#include "rtc_internal.h"          // On-chip RTC calendar, alarm + wakeup
+#include "usb_cdc.h"               // USB CDC-ACM log / telemetry export
+#include "clock_mgr.h"             // Idle / boost HCLK levels
+#include "timebase.h"              // TIM5 microsecond timebase + timers
+#include "sensor_stats.h"          // Welford stats + time-bucket rollups
+#include "history.h"               // Min/max downsampling pyramid for the chart
+#include "encoder.h"               // TIM8 quadrature encoder + select button
+#include "buzzer.h"                // TIM12 PWM non-blocking tone sequencer
 #include "sensors_lm75.h"          // LM75 temperature sensor driver
+#include "touch_sm.h"              // Press/release state machine (HAL-free)
+#include "touch_trace.h"           // Raw touch trace recorder
+#include "touch_predict.h"         // Drag position predictor
 
 #include <string.h>                 // Standard string utilities
 #include <stdio.h>                  // Standard formatted I/O utilities
+#include <stdlib.h>                 // abs()
 
 /* ============================= UI ENUMS ================================ */
 
@@ -34,7 +68,8 @@ typedef enum {
     UI_STARTUP = 0,                 // Startup screen shown after boot
     UI_CHECK,                       // Check screen for quick sensor queries
     UI_SETUP,                       // Setup screen for adjusting parameters
-    UI_PROJECT                      // Project screen for main logic display
+    UI_PROJECT,                     // Project screen for main logic display
+    UI_HISTORY                      // History chart, entered from PROJECT
 } UIState;                          // Tracks which UI screen is active
 
 typedef enum {
@@ -98,10 +133,21 @@ typedef enum {
 #define UBTN_H   36                 // Height of increment buttons
 #define UBTN_X   (VAL_X + VAL_W + 8) // X coordinate for increment buttons
 
+/* PROJECT screen */
+#define HBTN_X   (AREA_X + 10)      // X coordinate for "History" button
+#define HBTN_Y   (AREA_Y + 96)      // Y coordinate for "History" button
+#define HBTN_W   120                // Width of "History" button
+#define HBTN_H   28                 // Height of "History" button
+
 /* Auto-repeat timings */
 #define REPEAT_DELAY_MS  400        // Delay before auto-repeat starts when holding a button
 #define REPEAT_RATE_MS   100        // Interval between auto-repeat increments
 
+#define LOOP_PERIOD_MS   8          // Main loop pacing delay
+#define STATUS_PERIOD_S  60         // Interval of the console status lines (seconds)
+#define SERVO_STEP_US    20000U     // Servo sweep step period (one 50 Hz PWM frame)
+#define SERVO_FB_CHANNEL ADC_CHANNEL_14 // Servo feedback pot (PC4), read with injected conversions
+
 /* ========================== INLINE HELPERS ============================= */
 
 static inline uint8_t in_rect(uint16_t x, uint16_t y,
@@ -114,34 +160,44 @@ static inline uint8_t in_rect(uint16_t x, uint16_t y,
 /* ============================ UI STATE ================================= */
 
 static UIState  ui_state      = UI_STARTUP; // Current UI screen
-static uint8_t  was_down      = 0;          // Flag indicating previous touch state
-static uint16_t last_x        = 0;          // Last touch X coordinate
-static uint16_t last_y        = 0;          // Last touch Y coordinate
+static TouchSM  touch_sm;                   // Press/release tracking (last position, timing)
 static uint8_t  topbar_down   = 0;          // Flag indicating touch started on top bar
+static TouchPredictor touch_pred;           // Latency-compensated drag position
+static uint16_t drag_x        = 0;          // Predicted X for drag rendering (history chart pan)
+static uint16_t drag_y        = 0;          // Predicted Y for drag rendering
 
 static SetupHit  setup_active = SH_NONE;    // Active setup control for auto-repeat
+static SetupRow  enc_focus    = ROW_HOUR;   // Encoder focus on SETUP (ROW_NONE = "Done")
+static uint8_t   enc_edit     = 0;          // 1 while the encoder adjusts the focused value
 static uint32_t  setup_t0     = 0;          // Timestamp when touch began
 static uint32_t  setup_tlast  = 0;          // Timestamp of last auto-repeat action
 
 /* ============================= LIVE VALUES ============================= */
 
 static int   light_pct       = 0;      /* 0..100% mapped from ADC */ // Current light percentage
+static int   light_flicker   = 0;      /* percent flicker of last block */ // Flicker depth
+static uint16_t light_hz     = 0;      /* dominant flicker frequency */ // Flicker frequency in Hz
+static uint8_t  light_art    = 0;      /* 1 = artificial (100/120 Hz) light */ // Grow-light detection
 static float temp_c          = 26.5f;  /* LM75 temperature */         // Latest temperature reading
+static uint8_t temp_ok       = 0;      /* last LM75 read succeeded */ // temp_c is current, not stale
 static int   hour            = 12;     // Current hour value
 static int   minute          = 34;     // Current minute value
 static int   second          = 56;     // Current second value
 static int   temp_threshold  = 27;     /* User threshold */           // Temperature threshold set by user
 
 static uint8_t  relay_on      = 0;     // Relay state indicator
-static uint32_t proj_t0       = 0;     // Timestamp for project screen refresh
+static volatile uint8_t rtc_sec_tick = 0; // Set by the 1 Hz RTC wakeup event (project refresh)
+static volatile uint8_t tlm_due      = 0; // Set by the 1 Hz RTC wakeup event (USB telemetry)
+static volatile uint8_t stats_due    = 0; // Set by the 1 Hz RTC wakeup event (statistics sample)
 static uint8_t  time_from_rtc = 1;     /* 1=RTC, 0=software tick */  // Flag showing if time comes from RTC
-static uint8_t  time_dirty    = 0;     /* 1=needs write to DS1307 */ // Flag showing pending RTC write
+static uint8_t  time_dirty    = 0;     /* 1=needs write to RTCs   */ // Flag showing pending RTC write
+static uint8_t  i2c_fail_dumped = 0;   // I2C trace already dumped for the current failure streak
 
 /* SERVO state */
-static uint8_t  servo_enable  = 0;     // Servo sweep enable flag
 static int      servo_angle   = 0;     // Current servo angle
 static int8_t   servo_dir     = 1;     // Servo sweep direction
-static uint32_t servo_t0_ms   = 0;     // Timestamp for servo updates
+static TB_Timer servo_tmr;             // Sweep step timer (TIM5 compare), armed while relay ON
+static volatile uint16_t servo_fb_raw = 0; // Feedback pot, last injected conversion (0..4095)
 
 /* ============================= PROTOTYPES ============================== */
 
@@ -154,6 +210,8 @@ static void UI_DrawStartup(void);      // Render startup screen
 static void UI_DrawCheck(void);        // Render check screen
 static void UI_DrawSetup(void);        // Render setup screen
 static void UI_DrawProject(void);      // Render project screen
+static void UI_DrawHistory(void);      // Render history chart screen
+static void UI_HistoryUpdate(uint8_t force); // Redraw changed chart columns
 static void UI_ShowResult(const char *line); // Show result text on check screen
 
 static void Setup_PrintHour(void);     // Print hour value in setup UI
@@ -162,69 +220,88 @@ static void Setup_PrintTempTh(void);   // Print temperature threshold in setup U
 static SetupRow  setup_row_from_y(uint16_t y); // Map Y coordinate to setup row
 static SetupHit  setup_hit_test(uint16_t x, uint16_t y); // Determine which setup control is hit
 static void      setup_apply(SetupHit h); // Apply change based on setup control
-static void      Setup_CommitTimeToRTC(void); // Write updated time to DS1307
+static void      setup_adjust(SetupRow r, int32_t d); // Step a setup value by d with wrap
+static void      Setup_DrawFocus(void); // Mark encoder focus / edit state
+static void      Setup_CommitTimeToRTC(void); // Write updated time to both RTCs
 
 static void SERVO_SetAngle(int angle_deg); // Set servo angle via PWM
+static void servo_step(void *ctx);         // Servo sweep step (TIM5 timer callback)
+static void servo_fb_done(uint32_t channel, uint16_t value, void *ctx); // Feedback pot result (PendSV)
 
-static void REFRESH_Time_From_DS1307(void); // Update time variables from RTC
+static void REFRESH_Time_From_RTC(void);    // Update time variables from on-chip RTC
 static void REFRESH_Temp_From_LM75(void);   // Update temperature from LM75
 static void REFRESH_Light_From_ADC(void);   // Update light percentage from ADC
 
+static void UI_Switch(UIState s);       // Leave the current screen and draw another
+static void UI_Encoder(void);          // Apply encoder turns and clicks to the UI
 static void handle_touch_topbar(uint16_t x, uint16_t y); // Handle touches on navigation bar
 static void handle_touch_check(uint16_t x, uint16_t y);  // Handle touches on check screen
 static void handle_touch_setup_release(uint16_t x, uint16_t y); // Handle release on setup screen
 static void handle_touch_project(uint16_t x, uint16_t y); // Handle touches on project screen
+static void handle_touch_history(uint16_t x, uint16_t y); // Handle touches on history screen
 
 /* ============================ SENSOR HELPERS =========================== */
 
-static void REFRESH_Time_From_DS1307(void)
+static void REFRESH_Time_From_RTC(void)
 {
     DS1307_Time t;                             // Structure to hold RTC time
-    if (DS1307_ReadTime(&t) == HAL_OK) {       // Attempt to read time from RTC
-        hour   = (int)t.hours;                 // Copy hours to local variable
-        minute = (int)t.minutes;               // Copy minutes to local variable
-        second = (int)t.seconds;               // Copy seconds to local variable
-        time_from_rtc = 1;                     // Mark that time now comes from RTC
-    }
+    RTCInt_GetTime(&t);                        // Shadow-register read, no bus traffic
+    hour   = (int)t.hours;                     // Copy hours to local variable
+    minute = (int)t.minutes;                   // Copy minutes to local variable
+    second = (int)t.seconds;                   // Copy seconds to local variable
+    time_from_rtc = 1;                         // Mark that time now comes from RTC
 }
 
 static void REFRESH_Temp_From_LM75(void)
 {
     float c = 0.0f;                            // Temporary variable for temperature
-    if (LM75_ReadCelsius(&c) == HAL_OK) {      // Attempt to read temperature
-        temp_c = c;                            // Store temperature if read succeeded
+    if (LM75_ZoneCount()) {                    // Multi-zone: one batched burst over all LM75s
+        (void)LM75_PollAll();                  // Refresh every zone back to back
+        temp_ok = LM75_ZoneOk(0);              // Zone 0 drives the main reading
+        if (temp_ok) temp_c = LM75_ZoneTemps()[0];
+    } else {                                   // Fallback: single sensor at default address
+        temp_ok = (LM75_ReadCelsius(&c) == HAL_OK);
+        if (temp_ok) temp_c = c;               // Store temperature if read succeeded
     }
 }
 
-/* Light sensor on ADC1 / PC0 / IN10, 12-bit, mapped to 0..100% */
+/* Light sensor on ADC1 / PC0 / IN10, 12-bit, mapped to 0..100%.
+ * ADC1 runs continuously (light_capture.c); this maps the block DC level. */
 static void REFRESH_Light_From_ADC(void)
 {
-    HAL_StatusTypeDef st;                      // Status variable for ADC operations
-    uint32_t raw = 0U;                         // Raw ADC sample holder
+    LightCap_Result lr;                        // Latest capture block result
+    uint32_t raw = 0U;                         // Mean ADC level of the block
     uint32_t pct = 0U;                         // Non-inverted percentage placeholder
     uint32_t lpct = 0U;                        // Inverted and scaled light percentage
 
-    st = HAL_ADC_Start(&hadc1);                // Start ADC conversion
-    if (st != HAL_OK) return;                  // Abort if start failed
+    if (!LightCap_Get(&lr)) return;            // No block analysed yet (blocks arrive via EVT_LIGHT_BLOCK)
 
-    st = HAL_ADC_PollForConversion(&hadc1, 5); // Wait briefly for conversion
-    if (st == HAL_OK) {                        // Proceed if conversion succeeded
-        raw = HAL_ADC_GetValue(&hadc1);        // Read raw ADC value
-        if (raw > 4095U) raw = 4095U;          // Clamp value to 12-bit maximum
+    raw = lr.dc_raw;                           // DC level replaces the old single sample
+    if (raw > 4095U) raw = 4095U;              // Clamp value to 12-bit maximum
 
-        pct  = (raw * 100U) / 4095U;           // Convert to percentage (0..100%)
-        lpct = 100U - pct;                     // Invert so more light equals higher percentage
+    pct  = (raw * 100U) / 4095U;               // Convert to percentage (0..100%)
+    lpct = 100U - pct;                         // Invert so more light equals higher percentage
 
-        if (lpct <= 10U) {                     // Apply dead zone for low light
-            lpct = 0U;                         // Set to zero inside dead zone
-        } else {
-            lpct = (lpct - 10U) * 100U / 90U;  // Scale remaining range to 0..100
-        }
-
-        light_pct = (int)lpct;                 // Store computed light percentage
+    if (lpct <= 10U) {                         // Apply dead zone for low light
+        lpct = 0U;                             // Set to zero inside dead zone
+    } else {
+        lpct = (lpct - 10U) * 100U / 90U;      // Scale remaining range to 0..100
     }
 
-    HAL_ADC_Stop(&hadc1);                      // Stop ADC conversion
+    light_pct     = (int)lpct;                 // Store computed light percentage
+    light_flicker = lr.flicker_pct;            // Percent flicker of the same block
+    light_hz      = (uint16_t)((lr.peak_hz_x10 + 5U) / 10U); // Dominant flicker frequency
+    light_art     = lr.artificial;             // Mains-driven (grow light) detection
+}
+
+/* Light line on PROJECT screen: level plus flicker analysis */
+static void format_light_line(char *line, size_t n)
+{
+    if (light_art) {                            // Mains flicker found
+        snprintf(line, n, "Light=%d%% Flk=%d%%@%uHz", light_pct, light_flicker, light_hz); // Level + flicker
+    } else {
+        snprintf(line, n, "Light=%d%% Flk=%d%%", light_pct, light_flicker); // Level + flicker only
+    }
 }
 
 /* =========================== SERVO HELPER ============================== */
@@ -301,6 +378,17 @@ static void UI_DrawStartup(void)
     ILI9341_DrawString(AREA_X + 20, AREA_Y + 90,
                        "Tap any top button",
                        COLOR_GRAY, COLOR_BLACK, 2); // Prompt user to interact
+
+    const BKP_Fault *f = BKP_LastFault();       // Previous boot ended in a fault?
+    if (f) {
+        char line[48];                          // Buffer for fault summary
+        snprintf(line, sizeof(line), "Last reset: %s pc=%08lX",
+                 !BKP_LastFaultValid() ? "corrupt" :
+                 f->kind == BKP_FAULT_HARD ? "HardFault" : "Error",
+                 (unsigned long)f->pc);         // Fault kind and address
+        ILI9341_DrawString(AREA_X + 20, AREA_Y + 130,
+                           line, COLOR_RED, COLOR_BLACK, 1); // Small red notice
+    }
 }
 
 /* ============================ CHECK SCREEN ============================= */
@@ -411,36 +499,71 @@ static SetupHit setup_hit_test(uint16_t x, uint16_t y)
     return SH_NONE;                               // Default to no control hit
 }
 
-static void setup_apply(SetupHit h)
+static int wrap_range(int v, int lo, int n)
 {
-    switch (h) {                                  // Act based on active control
-        case SH_HOUR_PLUS:
+    v = (v - lo) % n;                             // Offset into the range
+    if (v < 0) v += n;                            // Negative steps wrap from the top
+    return lo + v;                                // Back to value units
+}
+
+/* d may be negative or large (encoder acceleration); values wrap */
+static void setup_adjust(SetupRow r, int32_t d)
+{
+    switch (r) {                                  // Act based on the row
+        case ROW_HOUR:
             time_from_rtc = 0;                    // Use software time after manual edit
             time_dirty    = 1;                    // Mark time as needing RTC commit
             second        = 0;                    // Reset seconds when hour changes
-            if (++hour >= 24) hour = 0;           // Wrap hour after 23
+            hour = wrap_range(hour + (int)d, 0, 24); // Wrap within 0..23
             Setup_PrintHour();                    // Refresh hour display
             break;
 
-        case SH_MIN_PLUS:
+        case ROW_MIN:
             time_from_rtc = 0;                    // Switch to software time after edit
             time_dirty    = 1;                    // Mark time dirty for RTC write
             second        = 0;                    // Reset seconds when minute changes
-            if (++minute >= 60) minute = 0;       // Wrap minute after 59
+            minute = wrap_range(minute + (int)d, 0, 60); // Wrap within 0..59
             Setup_PrintMin();                     // Refresh minute display
             break;
 
-        case SH_TTH_PLUS:
-            if (++temp_threshold > 35) temp_threshold = 20; // Cycle threshold within range
+        case ROW_TTH:
+            temp_threshold = wrap_range(temp_threshold + (int)d, 20, 16); // Cycle within 20..35
             Setup_PrintTempTh();                  // Refresh threshold display
             break;
 
         default:
-            break;                                // No action for SH_NONE
+            break;                                // No value on ROW_NONE
     }
 }
 
-/* Commit edited time to DS1307 and go back to RTC mode */
+static void setup_apply(SetupHit h)
+{
+    switch (h) {                                  // "+" buttons step by one
+        case SH_HOUR_PLUS: setup_adjust(ROW_HOUR, 1); break;
+        case SH_MIN_PLUS:  setup_adjust(ROW_MIN, 1);  break;
+        case SH_TTH_PLUS:  setup_adjust(ROW_TTH, 1);  break;
+        default:           break;                 // No action for SH_NONE
+    }
+}
+
+#define DONE_Y   (AREA_Y + 152)     // "Done" focus stop (encoder only) on SETUP
+
+/* Value box frames: white, yellow = encoder focus, red = editing */
+static void Setup_DrawFocus(void)
+{
+    static const uint16_t ys[3] = { VAL1_Y, VAL2_Y, VAL3_Y }; // Box per row
+    for (uint8_t i = 0; i < 3; i++) {
+        uint16_t c = COLOR_WHITE;                 // Unfocused frame
+        if (enc_focus == (SetupRow)(ROW_HOUR + i))
+            c = enc_edit ? COLOR_RED : COLOR_YELLOW; // Focused / editing
+        DrawFrame(VAL_X, ys[i], VAL_W, VAL_H, c);  // Redraw frame only
+    }
+    ILI9341_DrawString(AREA_X + 10, DONE_Y, "Done >",
+                       enc_focus == ROW_NONE ? COLOR_BLACK : COLOR_GRAY,
+                       enc_focus == ROW_NONE ? COLOR_YELLOW : COLOR_BLACK, 2); // Leave-screen stop
+}
+
+/* Commit edited time to on-chip RTC + DS1307 and go back to RTC mode */
 static void Setup_CommitTimeToRTC(void)
 {
     if (!time_dirty) return;                      // Exit if no pending edits
@@ -450,9 +573,9 @@ static void Setup_CommitTimeToRTC(void)
     t.minutes = (uint8_t)minute;                  // Populate minutes
     t.seconds = (uint8_t)second;                  // Populate seconds
 
-    if (DS1307_WriteTime(&t) == HAL_OK) {         // Attempt to write time to RTC
-        time_from_rtc = 1;                        // Switch back to RTC time on success
-    }
+    if (RTCInt_SetTimeBoth(&t) == HAL_OK)         // On-chip calendar + DS1307 reference
+        time_from_rtc = 1;                        // On-chip RTC carries the time from here
+                                                  // (on failure the software tick keeps the edit)
 
     time_dirty = 0;                               // Clear dirty flag regardless of result
 }
@@ -484,10 +607,71 @@ static void UI_DrawSetup(void)
     Setup_PrintHour();                            // Render current hour value
     Setup_PrintMin();                             // Render current minute value
     Setup_PrintTempTh();                          // Render current threshold value
+    Setup_DrawFocus();                            // Encoder focus marker
 }
 
 /* ============================ PROJECT SCREEN =========================== */
 
+#define ZONES_Y  (AREA_Y + 130)             // Y coordinate for per-zone temperature line
+
+static void UI_DrawZones(void)
+{
+    uint8_t n = LM75_ZoneCount();               // Number of discovered LM75 zones
+    if (n < 2) return;                          // Single sensor is already on the Temp line
+
+    const float *zc = LM75_ZoneTemps();         // Per-zone temperature array
+    char line[64];                              // Buffer for zone list
+    int len = snprintf(line, sizeof(line), "Zones:"); // Line prefix
+    for (uint8_t i = 0; i < n && len < (int)sizeof(line) - 6; i++) {
+        int t10 = (int)(zc[i] * 10 + (zc[i] < 0 ? -0.5f : 0.5f)); // Zone temperature in tenths
+        if (LM75_ZoneOk(i))
+            len += snprintf(line + len, sizeof(line) - len, " %d.%d", t10 / 10, (t10 < 0 ? -t10 : t10) % 10);
+        else
+            len += snprintf(line + len, sizeof(line) - len, " --.-"); // Zone failed this cycle
+    }
+    ILI9341_FillRect(AREA_X + 10, ZONES_Y, AREA_W - 20, 8, COLOR_BLACK); // Clear zone line
+    ILI9341_DrawString(AREA_X + 10, ZONES_Y, line, COLOR_WHITE, COLOR_BLACK, 1); // Small font fits 8 zones
+}
+
+#define SOIL_Y   (AREA_Y + 145)             // Y coordinate for soil moisture line
+
+static void UI_DrawSoil(void)
+{
+    Soil_Result sr;                             // Latest soil block result
+    if (!Soil_Get(&sr)) return;                 // No block processed yet
+
+    char line[64];                              // Buffer for probe list
+    int len = snprintf(line, sizeof(line), "Soil:"); // Line prefix
+    for (uint8_t i = 0; i < SOIL_PROBES && len < (int)sizeof(line) - 8; i++) {
+        if (sr.ok[i])
+            len += snprintf(line + len, sizeof(line) - len, " %u.%u%%",
+                            sr.vwc_x10[i] / 10U, sr.vwc_x10[i] % 10U); // Probe VWC in percent
+        else
+            len += snprintf(line + len, sizeof(line) - len, " open"); // Probe not connected
+    }
+    ILI9341_FillRect(AREA_X + 10, SOIL_Y, AREA_W - 20, 8, COLOR_BLACK); // Clear soil line
+    ILI9341_DrawString(AREA_X + 10, SOIL_Y, line, COLOR_WHITE, COLOR_BLACK, 1); // Small font below zones
+}
+
+#define FLOW_Y   (AREA_Y + 160)             // Y coordinate for water flow line
+
+static void UI_DrawFlow(void)
+{
+    Flow_Result fr;                             // Latest flow meter state
+    Flow_Get(&fr);                              // Copy counters and status
+
+    char line[64];                              // Buffer for flow text
+    snprintf(line, sizeof(line), "Flow: %u.%u L/min  Total: %lu.%02lu L%s%s",
+             fr.lpm_x10 / 10U, fr.lpm_x10 % 10U,
+             (unsigned long)(fr.volume_ml / 1000U), (unsigned long)(fr.volume_ml % 1000U / 10U),
+             (fr.status & FLOW_ST_LEAK)    ? " LEAK"    : "",
+             (fr.status & FLOW_ST_BLOCKED) ? " BLOCKED" : ""); // Rate, volume and faults
+    ILI9341_FillRect(AREA_X + 10, FLOW_Y, AREA_W - 20, 8, COLOR_BLACK); // Clear flow line
+    ILI9341_DrawString(AREA_X + 10, FLOW_Y, line,
+                       fr.status & (FLOW_ST_LEAK | FLOW_ST_BLOCKED) ? COLOR_RED : COLOR_WHITE,
+                       COLOR_BLACK, 1);         // Red when a fault is flagged
+}
+
 static void UI_DrawProject(void)
 {
     ILI9341_SetRotation(ILI9341_ROT_90);          // Ensure display rotation is correct
@@ -513,41 +697,306 @@ static void UI_DrawProject(void)
     ILI9341_DrawString(AREA_X + 10, AREA_Y + 42,
                        line, COLOR_WHITE, COLOR_BLACK, 2); // Display temperature data
 
-    snprintf(line, sizeof(line),
-             "Light=%d%%", light_pct);           // Format light percentage string
+    format_light_line(line, sizeof(line));        // Format light level and flicker
     ILI9341_DrawString(AREA_X + 10, AREA_Y + 72,
                        line, COLOR_WHITE, COLOR_BLACK, 2); // Display light reading
 
-    ILI9341_DrawString(AREA_X + 10, AREA_Y + 100,
-                       "Logic will run here...",
-                       COLOR_GRAY, COLOR_BLACK, 2); // Placeholder text for project logic
+    DrawButton(HBTN_X, HBTN_Y, HBTN_W, HBTN_H,
+               COLOR_GREEN, COLOR_WHITE, "History", 2); // Opens the history chart
+
+    UI_DrawZones();                               // Per-zone temperatures (multi-LM75 setups)
+    UI_DrawSoil();                                // Soil moisture per probe
+    UI_DrawFlow();                                // Water flow and volume
+}
+
+/* ============================ HISTORY SCREEN =========================== */
+
+#define HC_X     (AREA_X + 4)       // Chart left edge (first column)
+#define HC_Y     (AREA_Y + 18)      // Chart top
+#define HC_W     300                // Chart columns (one pyramid bucket each when zoom >= 0)
+#define HC_H     112                // Chart height in pixels
+#define HC_ZMIN  (-2)               // Zoomed in: one base bucket spans 4 columns
+#define HC_ZMAX  3                  // Zoomed out: 8 base buckets per column (whole 68 h)
+#define HC_NONE  0xFF               // Column cache: nothing drawn
+
+#define HB_Y     (HC_Y + HC_H + 8)  // History button row
+#define HB_W     56                 // History button width
+#define HB_H     36                 // History button height
+#define HB_X(i)  (HC_X + (i) * (HB_W + 4)) // History button i X coordinate
+
+static Hist_Channel hist_ch   = HIST_CH_TEMP; // Channel shown
+static int8_t   hist_z        = 0;      // Zoom: pyramid level (>= 0) or 2^-z columns per bucket
+static uint32_t hist_back     = 0;      // Right edge, base buckets before the newest (0 = live)
+static uint8_t  hist_drag     = 0;      // Stroke started inside the chart: it follows the finger
+static uint16_t hist_drag_x0  = 0;      // Stroke start X
+static uint32_t hist_drag_back = 0;     // hist_back at stroke start
+static uint8_t  hist_top[HC_W];         // Drawn segment per column (chart rows), for
+static uint8_t  hist_bot[HC_W];         // redrawing only the columns that change
+
+static const float    hist_vmin[HIST_CH_COUNT]  = { 0.0f, 0.0f };     // Fixed Y range per channel
+static const float    hist_vmax[HIST_CH_COUNT]  = { 50.0f, 100.0f };
+static const uint16_t hist_color[HIST_CH_COUNT] = { COLOR_ORANGE, COLOR_YELLOW };
+static const Stat_Channel hist_stat[HIST_CH_COUNT] = { STAT_CH_TEMP, STAT_CH_LIGHT }; // Rollups per channel
+
+static uint8_t hist_row(float v)
+{
+    float r = (hist_vmax[hist_ch] - v) * (float)(HC_H - 1)
+              / (hist_vmax[hist_ch] - hist_vmin[hist_ch]); // Top row is vmax
+    if (r < 0.0f) r = 0.0f;                     // Clamp above range
+    if (r > (float)(HC_H - 1)) r = (float)(HC_H - 1); // Clamp below range
+    return (uint8_t)(r + 0.5f);                 // Nearest chart row
+}
+
+/* One lookup per column: the bucket at the zoom level that column shows */
+static uint8_t hist_column(uint16_t c, float *lo, float *hi)
+{
+    uint32_t n = Hist_Count();                  // Base buckets available
+    if (n == 0U || hist_back >= n) return 0;    // Nothing at this position
+    uint32_t right = n - 1U - hist_back;        // Base bucket at the right edge
+    uint32_t off   = (uint32_t)(HC_W - 1 - c);  // Columns left of the right edge
+
+    if (hist_z >= 0) {                          // One level-z bucket per column
+        uint32_t r = right >> hist_z;           // Rightmost bucket at that level
+        if (off > r) return 0;                  // Before the first bucket
+        return Hist_Range(hist_ch, (uint8_t)hist_z, r - off, lo, hi);
+    }
+    off >>= -hist_z;                            // Several columns per base bucket
+    if (off > right) return 0;                  // Before the first bucket
+    return Hist_Range(hist_ch, 0, right - off, lo, hi);
+}
+
+static void hist_draw_column(uint16_t c, uint8_t top, uint8_t bot)
+{
+    uint16_t x = (uint16_t)(HC_X + c);          // Screen column
+    if (top == HC_NONE) {                       // No data: background only
+        ILI9341_FillRect(x, HC_Y, 1, HC_H, COLOR_BLACK);
+        return;
+    }
+    if (top > 0)                                // Above the min/max bar
+        ILI9341_FillRect(x, HC_Y, 1, top, COLOR_BLACK);
+    ILI9341_FillRect(x, (uint16_t)(HC_Y + top), 1, (uint16_t)(bot - top + 1), hist_color[hist_ch]); // Min..max bar
+    if (bot < HC_H - 1)                         // Below the bar
+        ILI9341_FillRect(x, (uint16_t)(HC_Y + bot + 1), 1, (uint16_t)(HC_H - 1 - bot), COLOR_BLACK);
+}
+
+/* v in tenths with sign, for the small-font caption */
+static int hist_tenths(float v)
+{
+    return (int)(v * 10.0f + (v < 0.0f ? -0.5f : 0.5f)); // Round half away from zero
+}
+
+static void hist_draw_caption(void)
+{
+    char line[64];                              // Caption buffer
+    char avg[24] = "";                          // 6 h mean and slow average, when known
+    Stat_Summary s;                             // Last six hours of this channel
+    uint32_t min_px = (hist_z >= 0) ? (HIST_BASE_MIN << hist_z) : HIST_BASE_MIN; // Minutes per bucket
+    if (Stats_Window(hist_stat[hist_ch], STAT_HOUR, 6, &s)) { // Open hour + 5 closed: O(6) merges
+        int m10 = hist_tenths(s.mean);          // 6 h mean, tenths
+        int e10 = hist_tenths(Stats_Ewma(hist_stat[hist_ch], 1)); // ~4 min average, tenths
+        snprintf(avg, sizeof(avg), " 6h %s%d.%d ~%s%d.%d",
+                 m10 < 0 ? "-" : "", abs(m10) / 10, abs(m10) % 10,
+                 e10 < 0 ? "-" : "", abs(e10) / 10, abs(e10) % 10);
+    }
+    snprintf(line, sizeof(line), "%s %d..%d  %lum/%s  %s%s",
+             hist_ch == HIST_CH_TEMP ? "Temp C" : "Light %",
+             (int)hist_vmin[hist_ch], (int)hist_vmax[hist_ch],
+             (unsigned long)min_px, hist_z >= 0 ? "px" : "bkt",
+             hist_back ? "paused" : "live  ", avg); // Channel, range, resolution, position, averages
+    ILI9341_FillRect(HC_X, AREA_Y + 6, HC_W, 8, COLOR_BLACK); // Clear caption line
+    ILI9341_DrawString(HC_X, AREA_Y + 6, line, COLOR_WHITE, COLOR_BLACK, 1); // Small font caption
+}
+
+/* Chart cost is HC_W pyramid lookups plus the columns that changed */
+static void UI_HistoryUpdate(uint8_t force)
+{
+    for (uint16_t c = 0; c < HC_W; c++) {       // Every chart column
+        float lo, hi;                           // Bucket min/max
+        uint8_t top = HC_NONE, bot = HC_NONE;   // Default: empty column
+        if (hist_column(c, &lo, &hi)) {         // Data for this column
+            top = hist_row(hi);                 // Max is drawn higher
+            bot = hist_row(lo);
+        }
+        if (force || top != hist_top[c] || bot != hist_bot[c]) { // Only changed columns
+            hist_draw_column(c, top, bot);      // Repaint this column
+            hist_top[c] = top;                  // Remember what is on screen
+            hist_bot[c] = bot;
+        }
+    }
+}
+
+static void UI_DrawHistory(void)
+{
+    ILI9341_SetRotation(ILI9341_ROT_90);        // Ensure display rotation is correct
+    ILI9341_FillScreen(COLOR_BLACK);            // Clear the screen
+    UI_DrawTopBar();                            // Draw navigation bar and frame
+
+    static const char *const lbl[5] = { "<", ">", "-", "+", "T/L" }; // Older, newer, zoom out/in, channel
+    for (uint8_t i = 0; i < 5; i++)
+        DrawButton(HB_X(i), HB_Y, HB_W, HB_H, COLOR_GREEN, COLOR_WHITE, lbl[i], 2); // Control row
+
+    hist_draw_caption();                        // Channel / zoom / position line
+    UI_HistoryUpdate(1);                        // Full chart paint
+}
+
+/* New base bucket: keep a paused view on the same time span */
+static void History_OnBucket(void)
+{
+    if (hist_back) hist_back++;                 // Paused: shift with the new bucket
+    if (hist_drag && hist_drag_back) hist_drag_back++; // Same for the drag anchor
+    if (ui_state != UI_HISTORY) return;         // Chart not shown: nothing to redraw
+    hist_draw_caption();                        // Averages moved on
+    UI_HistoryUpdate(0);                        // Live: scrolls, changed columns only
+}
+
+/* Move the view by cols chart columns; positive = older */
+static void hist_pan(int32_t cols)
+{
+    uint32_t mag  = (uint32_t)(cols < 0 ? -cols : cols); // Columns to move
+    uint32_t step = (hist_z >= 0) ? (mag << hist_z) : (mag >> -hist_z); // In base buckets
+    uint32_t n    = Hist_Count();               // Base buckets available
+    if (step == 0U) step = 1U;                  // Zoomed in: at least one bucket
+
+    if (cols > 0) {                             // Older, but keep one bucket on screen
+        hist_back = (hist_back + step < n) ? hist_back + step : (n ? n - 1U : 0U);
+    } else {                                    // Newer (back to live at 0)
+        hist_back = (hist_back > step) ? hist_back - step : 0U;
+    }
+}
+
+/* Stroke start: a press on the chart itself drags it */
+static void hist_drag_begin(uint16_t x, uint16_t y)
+{
+    hist_drag      = in_rect(x, y, HC_X, HC_Y, HC_W, HC_H); // Chart area only
+    hist_drag_x0   = x;                         // Anchor: finger X ...
+    hist_drag_back = hist_back;                 // ... and the view under it
+}
+
+/* Chart attached to the finger: one column per pixel, drag right = older */
+static void hist_drag_to(uint16_t x)
+{
+    uint32_t before = hist_back;                // View currently drawn
+    int32_t  cols   = (int32_t)x - (int32_t)hist_drag_x0; // Offset from the anchor
+
+    hist_back = hist_drag_back;                 // Pan from the anchor, not incrementally
+    if (cols != 0) hist_pan(cols);
+    if (hist_back == before) return;            // Same view: nothing to draw
+    hist_draw_caption();                        // live / paused may have changed
+    UI_HistoryUpdate(0);                        // Changed columns only
+}
+
+static void handle_touch_history(uint16_t x, uint16_t y)
+{
+    if (!in_rect(x, y, HC_X, HB_Y, 5 * (HB_W + 4), HB_H)) return; // Only the control row reacts
+
+    switch ((x - HC_X) / (HB_W + 4)) {          // Button index from X
+        case 0:                                 // Older: half a screen
+            hist_pan(HC_W / 2);
+            break;
+        case 1:                                 // Newer: half a screen
+            hist_pan(-(HC_W / 2));
+            break;
+        case 2:                                 // Zoom out: one level up
+            if (hist_z < HC_ZMAX) hist_z++;
+            break;
+        case 3:                                 // Zoom in
+            if (hist_z > HC_ZMIN) hist_z--;
+            break;
+        default:                                // Toggle temperature / light
+            hist_ch = (hist_ch == HIST_CH_TEMP) ? HIST_CH_LIGHT : HIST_CH_TEMP;
+            hist_draw_caption();                // New channel name and stats
+            UI_HistoryUpdate(1);                // Every column differs: full redraw
+            return;
+    }
+    hist_draw_caption();                        // Reflect the new view
+    UI_HistoryUpdate(0);                        // Pan/zoom redraws only what moved
 }
 
 /* ============================ TOUCH HANDLERS =========================== */
 
+static void UI_Switch(UIState s)
+{
+    if (ui_state == UI_SETUP && s != UI_SETUP) { // If leaving setup, commit time edits
+        Setup_CommitTimeToRTC();               // Write pending time to RTC
+    }
+    ui_state = s;                              // Switch state
+    enc_edit = 0;                              // Encoder back to focus navigation
+    switch (s) {
+        case UI_CHECK:   UI_DrawCheck();   break; // Redraw CHECK screen
+        case UI_SETUP:   UI_DrawSetup();   break; // Redraw SETUP screen
+        case UI_HISTORY: UI_DrawHistory(); break; // Full chart paint
+        case UI_PROJECT:
+            UI_DrawProject();                  // Redraw PROJECT screen
+            rtc_sec_tick = 0;                  // First refresh on the next RTC second
+            break;
+        default:         UI_DrawStartup(); break;
+    }
+}
+
 static void handle_touch_topbar(uint16_t x, uint16_t y)
 {
     if (in_rect(x, y, BTN_CHECK_X, NAV_Y, NAV_W, NAV_H)) { // Check if "Check" button pressed
-        if (ui_state == UI_SETUP) {            // If leaving setup, commit time edits
-            Setup_CommitTimeToRTC();           // Write pending time to RTC
-        }
-        ui_state = UI_CHECK;                   // Switch state to CHECK
-        UI_DrawCheck();                        // Redraw CHECK screen
+        UI_Switch(UI_CHECK);                   // Switch state to CHECK
     }
     else if (in_rect(x, y, BTN_SETUP_X, NAV_Y, NAV_W, NAV_H)) { // Check if "Setup" pressed
-        ui_state = UI_SETUP;                   // Switch state to SETUP
-        UI_DrawSetup();                        // Redraw SETUP screen
+        UI_Switch(UI_SETUP);                   // Switch state to SETUP
     }
     else if (in_rect(x, y, BTN_PROJ_X, NAV_Y, NAV_W, NAV_H)) { // Check if "Project" pressed
-        if (ui_state == UI_SETUP) {            // Commit edits if leaving SETUP
-            Setup_CommitTimeToRTC();           // Save time changes to RTC
-        }
-        ui_state = UI_PROJECT;                 // Switch state to PROJECT
-        UI_DrawProject();                      // Redraw PROJECT screen
-        proj_t0 = HAL_GetTick();               // Reset project refresh timer
+        UI_Switch(UI_PROJECT);                 // Switch state to PROJECT
     }
 }
 
+/* Encoder: SETUP   turn = move focus, or change the value while editing;
+ *                  click = edit on/off, or leave on "Done"
+ *          HISTORY turn = pan (accelerated), click = temp -> light -> back
+ *          others  click = next screen (CHECK -> SETUP -> PROJECT -> CHECK) */
+static void UI_Encoder(void)
+{
+    int32_t d     = Enc_Read(HAL_GetTick());    // Accelerated detents, + = clockwise
+    uint8_t click = Enc_Clicked();              // Debounced select press
+    if (!d && !click) return;                   // Nothing to do this pass
+    if (click) Buz_Play(BUZ_SEQ(Buz_Click), BUZ_PRIO_CLICK, 0); // Select click
+
+    Clock_Request(CLK_REQ_RENDER);              // Redraw at full clock
+    switch (ui_state) {
+        case UI_SETUP:
+            if (click) {
+                if (enc_focus == ROW_NONE) { UI_Switch(UI_PROJECT); break; } // "Done"
+                enc_edit ^= 1;                  // Toggle value editing
+                Setup_DrawFocus();
+            }
+            if (d && enc_edit) {
+                setup_adjust(enc_focus, d);     // Accelerated value change
+            } else if (d) {                     // One stop per turn, no acceleration
+                enc_focus = (SetupRow)wrap_range((int)enc_focus + (d > 0 ? 1 : -1), ROW_NONE, 4);
+                Setup_DrawFocus();
+            }
+            break;
+
+        case UI_HISTORY:
+            if (click) {
+                if (hist_ch == HIST_CH_LIGHT) { hist_ch = HIST_CH_TEMP; UI_Switch(UI_PROJECT); break; }
+                hist_ch = HIST_CH_LIGHT;        // Temp -> light
+                hist_draw_caption();
+                UI_HistoryUpdate(1);            // Other channel: full redraw
+            }
+            if (d) {
+                hist_pan(-d * 8);               // Clockwise = newer, 8 columns per detent
+                hist_draw_caption();
+                UI_HistoryUpdate(0);            // Changed columns only
+            }
+            break;
+
+        default:
+            if (click) {
+                UI_Switch(ui_state == UI_CHECK ? UI_SETUP :
+                          ui_state == UI_SETUP ? UI_PROJECT : UI_CHECK); // Cycle screens
+            }
+            break;
+    }
+    Clock_Release(CLK_REQ_RENDER);              // Drawing done
+}
+
 static void handle_touch_check(uint16_t x, uint16_t y)
 {
     char buf[40];                              // Buffer for result text
@@ -555,7 +1004,7 @@ static void handle_touch_check(uint16_t x, uint16_t y)
     /* Time button */
     if (in_rect(x, y, SBTN_T1_X, SBTN_ROW1_Y, SBTN_W, SBTN_H)) { // Touch on time button
         HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_SET); // Turn on debug LED
-        REFRESH_Time_From_DS1307();            // Read current time from RTC
+        REFRESH_Time_From_RTC();               // Read current time from RTC
         HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_RESET); // Turn off debug LED
 
         snprintf(buf, sizeof(buf),
@@ -591,15 +1040,16 @@ static void handle_touch_check(uint16_t x, uint16_t y)
                            buf, COLOR_WHITE, COLOR_BLACK, 2); // Show updated relay status
 
         if (relay_on) {                         // Actions when turning relay on
-            HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET); // Energize relay output
-            servo_enable = 1;                   // Enable servo sweep
+            RelayZones_SetZone(0, 1);           // Energize relay (zone 0)
+            Buz_Play(BUZ_SEQ(Buz_Irrigate), BUZ_PRIO_EVENT, 0); // Irrigation start chime
             servo_angle  = 0;                   // Reset servo angle
             servo_dir    = 1;                   // Start sweeping forward
-            servo_t0_ms  = HAL_GetTick();       // Capture time for servo scheduling
             SERVO_SetAngle(servo_angle);        // Apply initial servo position
+            TB_Start(&servo_tmr, TB_Deadline(SERVO_STEP_US), SERVO_STEP_US,
+                     servo_step, NULL);         // Sweep on exact 20 ms steps
         } else {                                // Actions when turning relay off
-            HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_RESET); // De-energize relay
-            servo_enable = 0;                   // Disable servo movement
+            RelayZones_SetZone(0, 0);           // De-energize relay (zone 0)
+            TB_Stop(&servo_tmr);                // Stop servo sweep
         }
     }
 }
@@ -613,9 +1063,194 @@ static void handle_touch_setup_release(uint16_t x, uint16_t y)
 
 static void handle_touch_project(uint16_t x, uint16_t y)
 {
-    (void)x;                                    // Suppress unused parameter warning
-    (void)y;                                    // Suppress unused parameter warning
-    /* Reserved for future project interactions */ // Placeholder for future logic
+    if (in_rect(x, y, HBTN_X, HBTN_Y, HBTN_W, HBTN_H)) { // History button
+        UI_Switch(UI_HISTORY);                  // Switch state to HISTORY
+    }
+}
+
+/* ================================ BUZZER =============================== */
+
+/* Loop the alarm while the flow meter reports a leak or blocked line */
+static void BUZ_FlowAlarm(void)
+{
+    static uint8_t alarm_on = 0;                // Alarm sequence currently looping
+    Flow_Result fr;                             // Fault bits
+    Flow_Get(&fr);                              // Latest flow status
+    uint8_t fault = (fr.status & (FLOW_ST_LEAK | FLOW_ST_BLOCKED)) != 0; // Leak or blocked line
+
+    if (fault && !alarm_on) {
+        alarm_on = Buz_Play(BUZ_SEQ(Buz_Alarm), BUZ_PRIO_ALARM, 1); // Repeats until the fault clears
+    } else if (!fault && alarm_on) {
+        Buz_Stop(BUZ_PRIO_ALARM);               // Silence
+        alarm_on = 0;
+    }
+}
+
+/* ============================== STATISTICS ============================= */
+
+/* One sample per channel per RTC second, whatever screen is shown */
+static void STATS_Sample(void)
+{
+    DS1307_Time t;                              // Wall clock for the bucket boundaries
+    Soil_Result sr = {0};                       // Soil probe results
+    Flow_Result fr;                             // Flow rate
+    RTCInt_GetTime(&t);                         // On-chip RTC, no bus traffic
+    if (Stats_Service(&t, RTCInt_GetDate()) & (1U << STAT_MINUTE)) { // Close minute/hour/day buckets first
+        Stat_Acc a;                             // Minute just closed
+        if (Stats_Bucket(STAT_CH_TEMP, STAT_MINUTE, 1, &a) && a.n)
+            Hist_AddMinute(HIST_CH_TEMP, a.min, a.max);   // Into the history base bucket
+        if (Stats_Bucket(STAT_CH_LIGHT, STAT_MINUTE, 1, &a) && a.n)
+            Hist_AddMinute(HIST_CH_LIGHT, a.min, a.max);
+        if (Hist_EndMinute()) History_OnBucket(); // Base bucket closed: chart may scroll
+    }
+
+    if (ui_state != UI_PROJECT) {               // PROJECT refresh already read them this second
+        REFRESH_Temp_From_LM75();               // Zone 0 temperature
+        REFRESH_Light_From_ADC();               // Light level of the latest block
+    }
+    if (temp_ok) Stats_Add(STAT_CH_TEMP, temp_c); // Degrees C; a failed read is no sample
+    Stats_Add(STAT_CH_LIGHT, (float)light_pct); // Percent
+
+    if (Soil_Get(&sr)) {                        // Mean over probes that see excitation
+        uint32_t sum = 0, k = 0;                // VWC sum (0.1 %) and live probe count
+        for (uint32_t i = 0; i < SOIL_PROBES; i++) {
+            if (sr.ok[i]) { sum += sr.vwc_x10[i]; k++; }
+        }
+        if (k) Stats_Add(STAT_CH_SOIL, (float)sum / (10.0f * (float)k)); // Percent
+    }
+
+    Flow_Get(&fr);                              // Instantaneous rate
+    Stats_Add(STAT_CH_FLOW, (float)fr.lpm_x10 / 10.0f); // L/min
+}
+
+/* ============================ USB TELEMETRY ============================ */
+
+#define TLM_CRC_LEN      11U                  // ",XXXXXXXX\r\n" closing every telemetry line
+
+static char             tlm_buf[2][96];       // Telemetry lines, sent over USB from these buffers
+static volatile uint8_t tlm_busy[2] = {0, 0}; // 1 while a buffer is queued on the bulk endpoint
+static uint8_t          tlm_i = 0;            // Buffer used for the next line
+static uint8_t          status_s = 0;         // Seconds since the last status lines
+
+static void tlm_done(void *ctx)
+{
+    tlm_busy[(uint32_t)(uintptr_t)ctx] = 0;     // On the wire: buffer free again (USB interrupt)
+}
+
+/* One CSV line per second: time, temp, light, soil VWC x3, volume, rate, zones,
+ * CRC32 (integrity.h) of every byte before its comma, as 8 hex digits */
+static void USB_SendTelemetry(void)
+{
+    if (!USBCDC_Ready() || tlm_busy[tlm_i]) return; // No terminal, or host not reading: skip
+
+    DS1307_Time t;                              // Wall-clock time for the record
+    Soil_Result sr = {0};                       // Soil probe results
+    Flow_Result fr;                             // Flow counters
+    RTCInt_GetTime(&t);                         // On-chip RTC, no bus traffic
+    (void)Soil_Get(&sr);                        // Zeros until the first block
+    Flow_Get(&fr);                              // Volume and rate
+
+    int t100 = (int)(temp_c * 100 + 0.5f);      // Temperature in hundredths
+    char *b = tlm_buf[tlm_i];                   // Format straight into the transmit buffer
+    int n = snprintf(b, sizeof(tlm_buf[0]) - TLM_CRC_LEN,
+                     "T,%02u:%02u:%02u,%d.%02d,%d,%u,%u,%u,%lu,%u,%02lX",
+                     t.hours, t.minutes, t.seconds, t100 / 100, t100 % 100, light_pct,
+                     sr.vwc_x10[0], sr.vwc_x10[1], sr.vwc_x10[2],
+                     (unsigned long)fr.volume_ml, fr.lpm_x10,
+                     (unsigned long)RelayZones_Actual()); // Telemetry record
+    if (n <= 0) return;                         // Nothing to send
+    if (n >= (int)(sizeof(tlm_buf[0]) - TLM_CRC_LEN))
+        n = sizeof(tlm_buf[0]) - TLM_CRC_LEN - 1; // Truncated record, CRC still fits
+    n += snprintf(b + n, TLM_CRC_LEN + 1U, ",%08lX\r\n",
+                  (unsigned long)Integrity_CRC32(b, (uint32_t)n)); // Checksum field closes the line
+
+    tlm_busy[tlm_i] = 1;                        // Owned by the USB queue until tlm_done()
+    if (!USBCDC_Submit(b, (uint32_t)n, tlm_done, (void *)(uintptr_t)tlm_i)) {
+        tlm_busy[tlm_i] = 0;                    // Not queued: keep the buffer
+        return;
+    }
+    tlm_i ^= 1U;                                // Next line goes to the other buffer
+}
+
+/* Console status lines:
+ *   U,tx bytes,tx transfers,rx bytes,dropped bytes,host baud
+ *   C,level,HCLK MHz,transitions,postponed,last us,max us,idle ms,boost ms
+ *   S,commanded deg,feedback deg,injected start failures */
+static void USB_SendStatus(void)
+{
+    USBCDC_Stats us;                            // USB CDC counters
+    USBCDC_GetStats(&us);                       // Snapshot since USBCDC_Init()
+    printf("U,%lu,%lu,%lu,%lu,%lu\r\n",
+           (unsigned long)us.tx_bytes, (unsigned long)us.tx_xfers,
+           (unsigned long)us.rx_bytes, (unsigned long)us.dropped,
+           (unsigned long)us.baud);             // ITM + console ring
+
+    Clock_Stats cs;                             // Clock scaling counters
+    Clock_GetStats(&cs);                        // Residency up to now, since Clock_Init()
+    printf("C,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+           cs.level == CLK_LVL_BOOST ? "boost" : "idle",
+           (unsigned long)(cs.hclk_hz / 1000000U),
+           (unsigned long)cs.transitions, (unsigned long)cs.postponed,
+           (unsigned long)cs.cost_last_us, (unsigned long)cs.cost_max_us,
+           (unsigned long)cs.res_ms[CLK_LVL_IDLE],
+           (unsigned long)cs.res_ms[CLK_LVL_BOOST]); // Switch cost and time at each level
+
+    printf("S,%d,%lu,%lu\r\n", servo_angle,
+           (unsigned long)servo_fb_raw * 180UL / 4095UL,
+           (unsigned long)ADC_Inject_StartFailures()); // Servo command vs. pot, ADC start failures
+}
+
+/* ============================ EVENT HANDLERS =========================== */
+
+static void on_light_block(const Event *ev, void *ctx)
+{
+    (void)ev; (void)ctx;                        // Half index is tracked by light_capture.c
+    Clock_Request(CLK_REQ_DSP);                 // FFT runs at full clock
+    if (LightCap_Process())                     // Window + FFT the finished block
+        REFRESH_Light_From_ADC();               // Light level/flicker only change here
+    Clock_Release(CLK_REQ_DSP);                 // Drop back at the next idle point
+}
+
+static void on_soil_block(const Event *ev, void *ctx)
+{
+    (void)ev; (void)ctx;                        // Half index is tracked by soil.c
+    Soil_Process();                             // Phase-split averages and VWC
+}
+
+static void servo_step(void *ctx)
+{
+    (void)ctx;                                  // TIM5 compare interrupt, every SERVO_STEP_US
+    servo_angle += (int)servo_dir * 5;          // Step servo angle by 5 degrees
+    if (servo_angle >= 180) {                   // If reached upper limit
+        servo_angle = 180;                      // Clamp to max
+        servo_dir   = -1;                       // Reverse direction
+    } else if (servo_angle <= 0) {              // If reached lower limit
+        servo_angle = 0;                        // Clamp to min
+        servo_dir   = 1;                        // Reverse direction
+    }
+    SERVO_SetAngle(servo_angle);                // Update servo position (CCR write only)
+    (void)ADC_Inject_Request(SERVO_FB_CHANNEL, ADC_SAMPLETIME_480CYCLES,
+                             servo_fb_done, NULL); // Where the last step got to; queue full: next frame
+}
+
+static void servo_fb_done(uint32_t channel, uint16_t value, void *ctx)
+{
+    (void)channel; (void)ctx;                   // PendSV, after the ADC interrupt latched the value
+    servo_fb_raw = value;                       // Reported on the S status line
+}
+
+static void on_rtc_wakeup(const Event *ev, void *ctx)
+{
+    (void)ev; (void)ctx;                        // Count is kept by rtc_internal.c
+    rtc_sec_tick = 1;                           // Paces the project screen refresh
+    tlm_due      = 1;                           // and the USB telemetry line
+    stats_due    = 1;                           // and the statistics sample
+}
+
+static void on_rtc_alarm(const Event *ev, void *ctx)
+{
+    (void)ev; (void)ctx;                        // Daily alarm A, set to midnight
+    Stats_EndDay(RTCInt_GetDate());             // Close the day bucket on the new RTC date
 }
 
 /* =============================== MAIN ================================== */
@@ -624,14 +1259,36 @@ int main(void)
 {
     HAL_Init();                                  // Initialize the HAL library
     SystemClock_Config();                        // Configure system clocks
+    BKP_Init();                                  // Backup SRAM: count boot, pick up last fault
+    BKP_Report();                                // Counters and last fault to the debug channel
 
     MX_GPIO_Init();                              // Initialize GPIO peripheral
+    MX_DMA_Init();                               // DMA2 clock + stream IRQs (before SPI1 links them)
+    Integrity_Init();                            // CRC peripheral + DMA feed
+    Integrity_SelfTest(NULL);                    // HW/DMA/SW agreement + throughput to debug channel
     MX_SPI1_Init();                              // Initialize SPI1 peripheral
     MX_ADC1_Init();                              // Initialize ADC1 peripheral
+    MX_ADC2_Init();                              // Initialize ADC2 (soil probe scan)
+    MX_TIM1_Init();                              // Initialize TIM1 (DMA I2C slot clock)
+    MX_TIM2_Init();                              // Initialize TIM2 (4 kHz ADC1 trigger, soil excitation)
+    MX_TIM3_Init();                              // Initialize TIM3 (flow pulse period capture)
     MX_TIM4_Init();                              // Initialize TIM4 peripheral
+    MX_TIM8_Init();                              // Initialize TIM8 (rotary encoder interface)
+    MX_TIM9_Init();                              // Initialize TIM9 (flow pulse counter, clocked by TIM3)
+    MX_TIM12_Init();                             // Initialize TIM12 (buzzer PWM on PB14)
+    USBCDC_Init();                               // USB OTG FS device (CDC-ACM), attaches to the host
+
+    Defer_Init();                                // PendSV bottom halves (lowest priority)
+    EventBus_Init();                             // Event queue ready before any ISR publishes
+    EventBus_Subscribe(EVT_LIGHT_BLOCK, on_light_block, NULL); // Light block -> FFT in main context
+    EventBus_Subscribe(EVT_SOIL_BLOCK,  on_soil_block,  NULL); // Soil block -> probe averages
+    EventBus_Subscribe(EVT_RTC_WAKEUP,  on_rtc_wakeup,  NULL); // 1 Hz RTC tick -> project refresh
+    EventBus_Subscribe(EVT_RTC_ALARM,   on_rtc_alarm,   NULL); // Midnight -> statistics day rollover
 
     SWI2C_Init_PB6_PB7();                        // Initialize software I2C on PB6/PB7
     SWI2C_BusClear();                            // Clear I2C bus state
+    I2CDMA_Init();                               // Slot timing for the Timer+DMA I2C engine
+    LM75_Discover();                             // Find LM75 zones at 0x48..0x4F (400 kHz), DS1307 stays at 100 kHz
 
     __HAL_RCC_GPIOB_CLK_ENABLE();                // Enable clock for GPIOB
 
@@ -644,61 +1301,98 @@ int main(void)
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW; // Low speed output
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);      // Apply configuration to PB13
 
-    /* PB12: relay control */
-    GPIO_InitStruct.Pin = GPIO_PIN_12;           // Select pin PB12
-    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);      // Apply configuration to PB12
-
     HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_RESET); // Ensure debug LED is off
-    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_RESET); // Ensure relay is off
+    RelayZones_Init();                           // Zone outputs (relay on PB12 = zone 0), all off
 
     HAL_TIM_PWM_Start(&htim4, TIM_CHANNEL_3);    // Start PWM generation on TIM4 channel 3
     SERVO_SetAngle(0);                           // Set servo to initial position
 
     DS1307_StartIfHalted();                      // Start RTC oscillator if it was halted
+    RTCInt_Init();                               // On-chip RTC on LSE, seeded/checked from DS1307
+    RTCInt_SetWakeup(1);                         // 1 Hz wakeup event replaces tick polling
+    RTCInt_SetAlarm(0, 0, 0);                    // Daily midnight alarm ends the statistics day
 
     ILI9341_Init(&hspi1);                        // Initialize TFT display driver
     ILI9341_SetRotation(ILI9341_ROT_90);         // Set display rotation
 
     HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_SET); // Turn on debug LED for sensor reads
-    REFRESH_Time_From_DS1307();                  // Fetch current time from RTC
+    REFRESH_Time_From_RTC();                     // Fetch current time from RTC
     REFRESH_Temp_From_LM75();                    // Fetch initial temperature
+    LightCap_Start();                            // Continuous 4 kHz light capture (ping-pong DMA)
+    Soil_Start();                                // Soil excitation + phase-locked probe scans
+    Flow_Start();                                // Flow pulses counted by TIM3/TIM9 from now on
+    HAL_Delay(LIGHT_N * 1000U / LIGHT_FS_HZ + 10U); // Let the first block complete
     REFRESH_Light_From_ADC();                    // Fetch initial light level
     HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_RESET); // Turn off debug LED after reads
 
     UI_DrawStartup();                            // Draw startup screen
 
     XPT_Init(&hspi1, 90, 320, 240);              // Initialize touch controller
+    Enc_Init(&htim8);                            // Encoder counting + select button
+    Buz_Init(&htim12);                           // Buzzer pin low, sequencer idle
     XPT_SetCalibration(350, 3683, 350, 3802);    // Apply touch calibration values
+    XPT_AuxEnable(XPT_AUX_VBAT, 1000);           // Backup battery on XPT VBAT pin, 1 Hz
+    XPT_AuxEnable(XPT_AUX_TEMP, 5000);           // XPT die temperature, every 5 s
 
-    while (1) {                                  // Main application loop
-        XPT_TouchPoint tp;                       // Structure to hold touch data
-
-        if (XPT_GetPoint(&tp)) {                 // Check if touch is detected
-            if (!was_down) {                     // If touch has just begun
-                was_down   = 1;                  // Mark touch as active
-                last_x     = tp.x;               // Store current X coordinate
-                last_y     = tp.y;               // Store current Y coordinate
+    TouchSM_Reset(&touch_sm);                    // Start with pen up
+    TouchPredict_Init(&touch_pred, SCR_W, SCR_H); // Predictor clamps to landscape screen
+#if TOUCH_TRACE_ENABLE
+    TouchTrace_Start();                          // Record raw samples from boot
+#endif
+    Stats_Init();                                // Empty rollups; first bucket closes at the next minute
+    Hist_Init();                                 // Empty chart pyramid
+    Clock_Init();                                // Boost/idle scaling from here on (all users set up)
 
+    while (1) {                                  // Main application loop
+        uint32_t loop_cyc = DWT->CYCCNT;         // Start of this pass (profiler maximum)
+        EventBus_Dispatch();                     // Run handlers for events raised by ISRs
+        RelayZones_Service(HAL_GetTick());       // Release staggered zone turn-ons
+        Flow_Process(HAL_GetTick(), RelayZones_Actual()); // Flow rate, volume, leak/blocked check
+        BUZ_FlowAlarm();                         // Alarm tone follows the flow fault bits
+        XPT_TouchPoint tp = {0};                 // Structure to hold touch data
+        uint8_t pressed = XPT_GetPoint(&tp);     // Sample touch controller
+        uint32_t sample_cyc = DWT->CYCCNT;       // Sample time for render-latency measurement
+
+        TouchEvent tev = TouchSM_Update(&touch_sm, pressed, tp.x, tp.y, HAL_GetTick()); // Classify sample
+        if (tev == TOUCH_EV_DOWN) Clock_Request(CLK_REQ_TOUCH); // Boost for the whole stroke, not per drag sample
+        switch (tev) {
+            case TOUCH_EV_DOWN: {               // Touch has just begun
+                TouchPredict_Reset(&touch_pred, tp.x, tp.y, touch_sm.t_down); // Fresh track per stroke
+                Buz_Play(BUZ_SEQ(Buz_Click), BUZ_PRIO_CLICK, 0); // Key click (ignored during an alarm)
+                drag_x = tp.x;                  // No lead until velocity is known
+                drag_y = tp.y;
                 topbar_down =
                     in_rect(tp.x, tp.y, BTN_CHECK_X, NAV_Y, NAV_W, NAV_H) || // Touch within "Check" button
                     in_rect(tp.x, tp.y, BTN_SETUP_X, NAV_Y, NAV_W, NAV_H) || // Touch within "Setup" button
                     in_rect(tp.x, tp.y, BTN_PROJ_X,  NAV_Y, NAV_W, NAV_H);   // Touch within "Project" button
 
+                if (ui_state == UI_HISTORY && !topbar_down) // Chart press starts a drag-to-pan
+                    hist_drag_begin(tp.x, tp.y);
+
                 if (ui_state == UI_SETUP && !topbar_down) { // If on SETUP screen and not on top bar
                     setup_active = setup_hit_test(tp.x, tp.y); // Determine which control is pressed
                     if (setup_active != SH_NONE) {             // If a control is active
-                        setup_t0    = HAL_GetTick();           // Record initial press time
+                        setup_t0    = touch_sm.t_down;         // Record initial press time
                         setup_tlast = setup_t0;                // Initialize last repeat time
                         setup_apply(setup_active);             // Apply immediate change
                     }
                 }
-            } else {                            // Touch is continuing
-                last_x = tp.x;                  // Update last X coordinate
-                last_y = tp.y;                  // Update last Y coordinate
+            } break;
+
+            case TOUCH_EV_HOLD:                 // Touch is continuing
+#if TOUCH_PREDICT_ENABLE
+                TouchPredict_Update(&touch_pred, tp.x, tp.y, touch_sm.t_last); // Track velocity/accel
+                TouchPredict_Get(&touch_pred, &drag_x, &drag_y); // Position drag items should use
+#else
+                drag_x = tp.x;                  // Predictor disabled: follow raw point
+                drag_y = tp.y;
+#endif
+                if (ui_state == UI_HISTORY && hist_drag) // Chart tracks the predicted finger position
+                    hist_drag_to(drag_x);
 
                 if (ui_state == UI_SETUP && setup_active != SH_NONE) { // Handle auto-repeat on SETUP screen
                     if (setup_hit_test(tp.x, tp.y) == setup_active) { // Confirm finger still on control
-                        uint32_t now = HAL_GetTick();           // Get current time
+                        uint32_t now = touch_sm.t_last;         // Time of this sample
                         if ((now - setup_t0)   >= REPEAT_DELAY_MS &&
                             (now - setup_tlast) >= REPEAT_RATE_MS) { // Check repeat timing
                             setup_tlast = now;                  // Update last repeat time
@@ -706,11 +1400,11 @@ int main(void)
                         }
                     }
                 }
-            }
-        } else {                                // No touch currently detected
-            if (was_down) {                     // If touch was previously active
-                uint16_t x = last_x;            // Capture last touch X coordinate
-                uint16_t y = last_y;            // Capture last touch Y coordinate
+                break;
+
+            case TOUCH_EV_UP: {                 // Touch released
+                uint16_t x = touch_sm.x;        // Last valid touch X coordinate
+                uint16_t y = touch_sm.y;        // Last valid touch Y coordinate
 
                 if (topbar_down) {              // If touch started on navigation bar
                     handle_touch_topbar(x, y);  // Process navigation touch
@@ -727,35 +1421,53 @@ int main(void)
                         case UI_PROJECT:
                             handle_touch_project(x, y); // Handle project screen release
                             break;
+                        case UI_HISTORY:
+                            handle_touch_history(x, y); // Handle history controls
+                            break;
                     }
                 }
 
-                was_down     = 0;               // Reset touch active flag
                 topbar_down  = 0;               // Clear navigation touch flag
                 setup_active = SH_NONE;         // Clear active setup control
-            }
+                hist_drag    = 0;               // Chart drag ends with the stroke
+            } break;
+
+            default:
+                break;                          // Pen still up
+        }
+        if (tev == TOUCH_EV_UP) Clock_Release(CLK_REQ_TOUCH); // Stroke handled: idle at the next idle point
+        UI_Encoder();                           // Encoder turns / clicks (hardware counted)
+
+#if TOUCH_PREDICT_ENABLE
+        if (tev == TOUCH_EV_HOLD) {             // Measure sample -> drawn latency while dragging
+            uint32_t cyc = DWT->CYCCNT - sample_cyc; // Cycles spent handling/rendering this sample
+            TouchPredict_AddLatency(&touch_pred,
+                                    (float)cyc / (float)(SystemCoreClock / 1000U) + LOOP_PERIOD_MS); // + loop pacing delay
         }
+#else
+        (void)sample_cyc;                       // Only used by the predictor
+#endif
+
+#if TOUCH_TRACE_ENABLE
+        if (TouchTrace_Full()) {                // Buffer filled: export once over ITM
+            TouchTrace_Dump();                  // Blocking CSV dump (debug builds only)
+            TouchTrace_Stop();                  // Keep contents for a debugger read-out
+        }
+#endif
 
         /* PROJECT screen periodic refresh */
         if (ui_state == UI_PROJECT) {           // Execute periodic updates on project screen
-            uint32_t now = HAL_GetTick();       // Capture current system tick
-            if (now - proj_t0 >= 1000U) {       // Check if one second elapsed
-                proj_t0 = now;                  // Reset project refresh timer
+            if (rtc_sec_tick) {                 // RTC wakeup: one second elapsed
+                rtc_sec_tick = 0;               // Consume the tick
+                Clock_Request(CLK_REQ_RENDER);  // Redraw at full clock
 
                 HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_SET); // Turn on debug LED during refresh
 
-                DS1307_Time t;                  // Temporary structure for RTC reads
                 float c = 0.0f;                 // Temporary temperature variable
-                HAL_StatusTypeDef st1 = HAL_OK; // Status for RTC read
                 HAL_StatusTypeDef st2;          // Status for temperature read
 
                 if (time_from_rtc) {            // If using RTC as time source
-                    st1 = DS1307_ReadTime(&t);  // Attempt to read time from RTC
-                    if (st1 == HAL_OK) {        // If read successful
-                        hour   = t.hours;       // Update hour
-                        minute = t.minutes;     // Update minute
-                        second = t.seconds;     // Update second
-                    }
+                    REFRESH_Time_From_RTC();    // On-chip calendar, cannot fail
                 } else {                        // If using software timekeeping
                     second++;                   // Increment seconds
                     if (second >= 60) {         // Handle minute rollover
@@ -769,8 +1481,15 @@ int main(void)
                     }
                 }
 
-                st2 = LM75_ReadCelsius(&c);     // Read temperature from LM75
-                if (st2 == HAL_OK) {            // If temperature read succeeded
+                if (LM75_ZoneCount()) {         // Multi-zone: poll all LM75s in one burst
+                    (void)LM75_PollAll();       // Read every zone back to back
+                    st2 = LM75_ZoneOk(0) ? HAL_OK : HAL_ERROR; // Zone 0 drives the main reading
+                    c   = LM75_ZoneTemps()[0];  // Zone 0 temperature
+                } else {
+                    st2 = LM75_ReadCelsius(&c); // Read temperature from LM75
+                }
+                temp_ok = (st2 == HAL_OK);      // Statistics skip a failed read
+                if (temp_ok) {                  // If temperature read succeeded
                     temp_c = c;                 // Update stored temperature
                 }
 
@@ -778,16 +1497,22 @@ int main(void)
 
                 HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_RESET); // Turn off debug LED after refresh
 
+#if I2C_TRACE_ENABLE
+                if (st2 != HAL_OK) {            // Bus failure this cycle
+                    if (!i2c_fail_dumped) {     // Dump once per failure streak
+                        I2CTrace_Dump();        // Last transactions to the debug channel
+                        i2c_fail_dumped = 1;    // Suppress repeats until the bus recovers
+                    }
+                } else {
+                    i2c_fail_dumped = 0;        // Bus healthy again
+                }
+#endif
+
                 char line[64];                  // Buffer for display strings
 
                 ILI9341_FillRect(AREA_X + 10, AREA_Y + 12, 220, 16, COLOR_BLACK); // Clear time display area
-                if (time_from_rtc && (st1 != HAL_OK)) { // Check for RTC read failure
-                    snprintf(line, sizeof(line),
-                             "Time: --:--:-- (I2C FAIL)"); // Show error message
-                } else {
-                    snprintf(line, sizeof(line),
-                             "Time: %02d:%02d:%02d", hour, minute, second); // Show current time
-                }
+                snprintf(line, sizeof(line),
+                         "Time: %02d:%02d:%02d", hour, minute, second); // Show current time
                 ILI9341_DrawString(AREA_X + 10, AREA_Y + 12,
                                    line, COLOR_WHITE, COLOR_BLACK, 2); // Display time string
 
@@ -804,32 +1529,37 @@ int main(void)
                 ILI9341_DrawString(AREA_X + 10, AREA_Y + 42,
                                    line, COLOR_WHITE, COLOR_BLACK, 2); // Display temperature string
 
-                ILI9341_FillRect(AREA_X + 10, AREA_Y + 72, 180, 16, COLOR_BLACK); // Clear light display area
-                snprintf(line, sizeof(line),
-                         "Light=%d%%", light_pct); // Format light percentage
+                ILI9341_FillRect(AREA_X + 10, AREA_Y + 72, AREA_W - 20, 16, COLOR_BLACK); // Clear light display area
+                format_light_line(line, sizeof(line)); // Format light level and flicker
                 ILI9341_DrawString(AREA_X + 10, AREA_Y + 72,
                                    line, COLOR_WHITE, COLOR_BLACK, 2); // Display light percentage
+
+                UI_DrawZones();                 // Refresh per-zone temperatures
+                UI_DrawSoil();                  // Refresh soil moisture
+                UI_DrawFlow();                  // Refresh flow and volume
+                Clock_Release(CLK_REQ_RENDER);  // Redraw finished
             }
         }
 
-        /* Non-blocking servo sweep while relay ON */
-        if (servo_enable) {                      // Only update servo when enabled
-            uint32_t now = HAL_GetTick();       // Get current tick
-            if (now - servo_t0_ms >= 20U) {     // Check if update interval elapsed
-                servo_t0_ms = now;              // Refresh servo timer
-                servo_angle += (int)servo_dir * 5; // Step servo angle by 5 degrees
-                if (servo_angle >= 180) {       // If reached upper limit
-                    servo_angle = 180;          // Clamp to max
-                    servo_dir   = -1;           // Reverse direction
-                } else if (servo_angle <= 0) {  // If reached lower limit
-                    servo_angle = 0;            // Clamp to min
-                    servo_dir   = 1;            // Reverse direction
-                }
-                SERVO_SetAngle(servo_angle);    // Update servo position
+        BKP_Max(&BKP_REGION->loop_max_cyc, DWT->CYCCNT - loop_cyc); // Worst pass, kept across resets
+        BKP_Tick(HAL_GetTick());                 // Uptime + profiler maxima to backup SRAM
+        RTCInt_Service(HAL_GetTick());           // Hourly DS1307 drift cross-check
+        if (stats_due) {                         // Once per RTC second
+            stats_due = 0;                       // Consume the tick
+            STATS_Sample();                      // Feed the statistics engine
+        }
+        if (tlm_due) {                           // Once per RTC second
+            tlm_due = 0;                         // Consume the tick
+            USB_SendTelemetry();                 // Queue a telemetry line (never waits)
+            if (++status_s >= STATUS_PERIOD_S) { // Once a minute
+                status_s = 0;                    // Restart the interval
+                USB_SendStatus();                // USB and clock counters to the console
             }
         }
+        USBCDC_Poll();                           // Push console output written this pass
 
-        HAL_Delay(8);                            // Small delay to pace loop
+        Clock_IdlePoint();                       // Drop to idle clock unless a burst holds boost
+        HAL_Delay(LOOP_PERIOD_MS);               // Small delay to pace loop
     }
 }
 
@@ -851,7 +1581,7 @@ void SystemClock_Config(void)
     RCC_OscInitStruct.PLL.PLLM            = 8;                      // PLLM divisor
     RCC_OscInitStruct.PLL.PLLN            = 168;                    // PLLN multiplier
     RCC_OscInitStruct.PLL.PLLP            = RCC_PLLP_DIV2;          // PLLP divisor
-    RCC_OscInitStruct.PLL.PLLQ            = 4;                      // PLLQ divisor
+    RCC_OscInitStruct.PLL.PLLQ            = 7;                      // PLLQ divisor: 336/7 = 48 MHz for USB OTG FS
     if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK) { // Apply oscillator configuration
         Error_Handler();                         // Handle configuration error
     }
@@ -870,12 +1600,26 @@ void SystemClock_Config(void)
     }
 }
 
+/* ============================ DEBUG CHANNEL ============================ */
+
+/* printf() → ITM stimulus port 0 (SWV console in CubeIDE) and the USB CDC console ring. */
+int __io_putchar(int ch)
+{
+    char c = (char)ch;                           // Byte for the USB ring
+    ITM_SendChar((uint32_t)ch);                  // Drop the character into ITM port 0
+    if (__get_IPSR() == 0U) {                    // The ring has one writer, the main loop:
+        (void)USBCDC_Write(&c, 1);               // printf from an ISR reaches ITM only
+    }                                            // (dropped while no terminal is open)
+    return ch;                                   // Report success to newlib
+}
+
 /* ============================ ERROR HANDLER ============================ */
 
 void Error_Handler(void)
 {
     __disable_irq();                             // Disable interrupts to enter safe state
-    while (1) {                                  // Infinite loop to indicate fatal error
+    BKP_FaultFromError((uint32_t)(uintptr_t)__builtin_return_address(0)); // Snapshot caller, reset
+    while (1) {                                  // Not reached: reset above
     }
 }
 
@@ -0,0 +1,41 @@
+#include "mpsc_ring.h"
+
+void MPSC_Init(MPSC_Ring *r, volatile uint32_t *seq, uint32_t depth){
+  r->seq  = seq;
+  r->mask = depth - 1u;
+  r->head = 0;
+  r->tail = 0;
+  for (uint32_t i = 0; i < depth; i++) seq[i] = i;
+}
+
+uint8_t MPSC_Claim(MPSC_Ring *r, uint32_t *pos){
+  for (;;){
+    uint32_t p    = __LDREXW(&r->head);
+    int32_t  diff = (int32_t)(r->seq[p & r->mask] - p);
+    if (diff == 0){                             /* free for p: claim it */
+      if (!__STREXW(p + 1u, &r->head)){ *pos = p; return 1; }
+      continue;
+    }
+    __CLREX();
+    if (diff < 0) return 0;                     /* consumer has not freed it: full */
+    /* diff > 0: a preempting producer took p after our load; reload */
+  }
+}
+
+void MPSC_Commit(MPSC_Ring *r, uint32_t pos){
+  __DMB();                                      /* payload visible before the release */
+  r->seq[pos & r->mask] = pos + 1u;
+}
+
+uint8_t MPSC_Peek(MPSC_Ring *r, uint32_t *pos){
+  if (r->seq[r->tail & r->mask] != r->tail + 1u) return 0;
+  __DMB();                                      /* payload reads after the seq check */
+  *pos = r->tail;
+  return 1;
+}
+
+void MPSC_Release(MPSC_Ring *r){
+  __DMB();                                      /* payload copied before the slot is reused */
+  r->seq[r->tail & r->mask] = r->tail + r->mask + 1u;
+  r->tail++;
+}
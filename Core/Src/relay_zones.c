@@ -0,0 +1,75 @@
+#include "relay_zones.h"
+
+static const uint16_t rz_pin[RZ_COUNT] = RZ_PINS;
+
+static volatile uint8_t rz_target = 0;
+static uint8_t  rz_actual = 0;
+static uint32_t rz_t_on   = 0;                  /* tick of the last inrush turn-on */
+static uint8_t  rz_fresh  = 1;                  /* no inrush turn-on yet */
+
+#define RZ_ALL  ((uint8_t)((1u << RZ_COUNT) - 1u))
+
+/* One BSRR write: set bits in the low half, reset bits in the high half */
+static void rz_write(uint8_t mask){
+  uint32_t set = 0, clr = 0;
+  for (uint8_t i = 0; i < RZ_COUNT; i++){
+    uint8_t level = (uint8_t)(((mask ^ RZ_ACTIVE_LOW) >> i) & 1u);
+    if (level) set |= rz_pin[i];
+    else       clr |= rz_pin[i];
+  }
+  RZ_PORT->BSRR = set | (clr << 16);
+  rz_actual = mask;
+}
+
+void RelayZones_Init(void){
+  GPIO_InitTypeDef g = {0};
+  __HAL_RCC_GPIOB_CLK_ENABLE();
+
+  rz_target = 0;
+  rz_write(0);                                  /* latch "off" before the pins become outputs */
+  for (uint8_t i = 0; i < RZ_COUNT; i++) g.Pin |= rz_pin[i];
+  g.Mode  = GPIO_MODE_OUTPUT_PP;
+  g.Pull  = GPIO_NOPULL;
+  g.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(RZ_PORT, &g);
+  rz_fresh = 1;
+}
+
+uint8_t RelayZones_Service(uint32_t now_ms){
+  uint8_t target = rz_target & RZ_ALL;
+  uint8_t next   = rz_actual & target;          /* offs: immediately */
+
+  /* zones without inrush follow the target directly */
+  next |= target & (uint8_t)~RZ_INRUSH_MASK;
+
+  /* at most one inrush zone per RZ_STAGGER_MS, valves before pumps */
+  uint8_t pend = target & (uint8_t)~next;
+  if (pend && (rz_fresh || now_ms - rz_t_on >= RZ_STAGGER_MS)){
+    uint8_t pick = pend & (uint8_t)~RZ_PUMP_MASK;
+    if (!pick) pick = pend;
+    pick &= (uint8_t)-pick;                     /* lowest zone first */
+    next |= pick;
+    rz_t_on  = now_ms;
+    rz_fresh = 0;
+  }
+
+  if (next != rz_actual) rz_write(next);
+  return rz_actual;
+}
+
+void RelayZones_Set(uint8_t mask){
+  rz_target = mask & RZ_ALL;
+  (void)RelayZones_Service(HAL_GetTick());
+}
+
+void RelayZones_SetZone(uint8_t zone, uint8_t on){
+  if (zone >= RZ_COUNT) return;
+  uint8_t m = rz_target;
+  if (on) m |=  (uint8_t)(1u << zone);
+  else    m &= (uint8_t)~(1u << zone);
+  RelayZones_Set(m);
+}
+
+uint8_t RelayZones_Target(void){ return rz_target; }
+uint8_t RelayZones_Actual(void){ return rz_actual; }
+uint8_t RelayZones_Busy(void)  { return (uint8_t)((rz_target & (uint8_t)~rz_actual) != 0u); }
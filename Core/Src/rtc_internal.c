@@ -0,0 +1,251 @@
+#include "rtc_internal.h"
+#include "event_bus.h"
+
+#define EXTI_ALARM   (1u << 17)
+#define EXTI_WAKEUP  (1u << 22)
+#define SPIN_MAX     200000u                   /* register handshakes, ~ms  */
+
+static uint8_t      src = RTCINT_SRC_NONE;
+static RTCInt_Stats st;
+static uint32_t     sync_t0 = 0;               /* last cross-check          */
+static uint32_t     seed_t0 = 0;               /* last (re)seed, drift base */
+
+/* BCD helpers */
+static uint8_t bcd_to_dec(uint32_t v){ return (uint8_t)(((v >> 4) & 0x0Fu) * 10u + (v & 0x0Fu)); }
+static uint32_t dec_to_bcd(uint8_t v){ return (uint32_t)(((v / 10u) << 4) | (v % 10u)); }
+
+/* ====== Register access ====== */
+static void wp_unlock(void){ RTC->WPR = 0xCAu; RTC->WPR = 0x53u; }
+static void wp_lock(void)  { RTC->WPR = 0xFFu; }
+
+/* ISR flags are rc_w0: write ones everywhere except the flag to clear. INIT
+   is the only rw bit and is written 0, so not for use inside init mode. */
+static void isr_clear(uint32_t flag){ RTC->ISR = ~(uint32_t)(flag | RTC_ISR_INIT); }
+
+static uint8_t spin(volatile uint32_t *reg, uint32_t mask){
+  for (uint32_t n = SPIN_MAX; n; n--) if (*reg & mask) return 1;
+  return 0;
+}
+
+static HAL_StatusTypeDef cal_write(uint32_t tr, uint32_t dr){
+  wp_unlock();
+  RTC->ISR |= RTC_ISR_INIT;
+  if (!spin(&RTC->ISR, RTC_ISR_INITF)){ wp_lock(); return HAL_TIMEOUT; }
+
+  uint32_t prediv_s = (src == RTCINT_SRC_LSI) ? 249u : 255u;   /* ck_spre = 1 Hz */
+  RTC->PRER = prediv_s;
+  RTC->PRER = prediv_s | (127u << RTC_PRER_PREDIV_A_Pos);
+  RTC->CR  &= ~RTC_CR_FMT;                                     /* 24 h */
+  RTC->TR   = tr & (RTC_TR_HT | RTC_TR_HU | RTC_TR_MNT | RTC_TR_MNU | RTC_TR_ST | RTC_TR_SU);
+  RTC->DR   = dr;
+
+  RTC->ISR = ~(uint32_t)(RTC_ISR_INIT | RTC_ISR_RSF);        /* leave init, resync shadows */
+  uint8_t ok = spin(&RTC->ISR, RTC_ISR_RSF);
+  wp_lock();
+  return ok ? HAL_OK : HAL_TIMEOUT;
+}
+
+static uint32_t tr_from(const DS1307_Time *t){
+  return (dec_to_bcd(t->hours) << 16) | (dec_to_bcd(t->minutes) << 8) | dec_to_bcd(t->seconds);
+}
+
+static void exti_rising(uint32_t line, IRQn_Type irq){
+  EXTI->PR    = line;
+  EXTI->RTSR |= line;
+  EXTI->FTSR &= ~line;
+  EXTI->IMR  |= line;
+  HAL_NVIC_SetPriority(irq, 0, 0);
+  HAL_NVIC_EnableIRQ(irq);
+}
+
+/* ====== Clock source ====== */
+static uint8_t lse_start(void){
+  RCC->BDCR |= RCC_BDCR_LSEON;
+  uint32_t t0 = HAL_GetTick();
+  while (!(RCC->BDCR & RCC_BDCR_LSERDY)){
+    if (HAL_GetTick() - t0 >= RTCINT_LSE_TIMEOUT_MS){
+      RCC->BDCR &= ~RCC_BDCR_LSEON;
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void lsi_start(void){
+  RCC->CSR |= RCC_CSR_LSION;                   /* not in the backup domain: off after reset */
+  while (!(RCC->CSR & RCC_CSR_LSIRDY)) { }
+}
+
+/* RTC weekday (1 = Monday .. 7 = Sunday) from the date. The DS1307 day
+   register counts 1..7 from a user-chosen start, so it is not copied. */
+static uint32_t weekday(uint32_t y, uint32_t m, uint32_t d){
+  static const uint8_t t[12] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+  if (m < 1u || m > 12u) m = 1u;
+  if (m < 3u) y--;
+  uint32_t w = (y + y / 4u - y / 100u + y / 400u + t[m - 1u] + d) % 7u;   /* 0 = Sunday */
+  return w ? w : 7u;
+}
+
+/* Whole DS1307 calendar (BCD) straight into TR/DR. */
+static HAL_StatusTypeDef seed_from_ds1307(void){
+  uint8_t r[7];
+  HAL_StatusTypeDef s = DS1307_ReadReg(DS1307_REG_SECONDS, r, 7);
+  if (s != HAL_OK) return s;
+  uint32_t wd = weekday(2000u + bcd_to_dec(r[6]), bcd_to_dec(r[5] & 0x1Fu), bcd_to_dec(r[4] & 0x3Fu));
+  uint32_t tr = ((uint32_t)(r[2] & 0x3Fu) << 16) | ((uint32_t)(r[1] & 0x7Fu) << 8) | (r[0] & 0x7Fu);
+  uint32_t dr = ((uint32_t)r[6] << 16) | (wd << 13) | ((uint32_t)(r[5] & 0x1Fu) << 8) | (r[4] & 0x3Fu);
+  return cal_write(tr, dr);
+}
+
+static int32_t sod(const DS1307_Time *t){
+  return (int32_t)t->hours * 3600 + (int32_t)t->minutes * 60 + (int32_t)t->seconds;
+}
+
+static void cross_check(uint32_t now_ms){
+  DS1307_Time ds, rt;
+  if (DS1307_ReadTime(&ds) != HAL_OK){ st.sync_errors++; return; }
+  RTCInt_GetTime(&rt);
+  st.syncs++;
+
+  int32_t d = sod(&ds) - sod(&rt);
+  if (d >=  43200) d -= 86400;                 /* across midnight */
+  if (d <  -43200) d += 86400;
+  st.drift_last_s = d;
+
+  uint32_t el_s = (now_ms - seed_t0) / 1000u;
+  if (el_s) st.drift_ppm = (int32_t)((int64_t)d * 1000000 / (int64_t)el_s);
+
+  if (d > RTCINT_SYNC_TOL_S || d < -RTCINT_SYNC_TOL_S){
+    if (RTCInt_SetTime(&ds) == HAL_OK) st.corrections++;
+    seed_t0 = now_ms;
+  }
+}
+
+/* ====== API ====== */
+void RTCInt_Init(void){
+  __HAL_RCC_PWR_CLK_ENABLE();
+  HAL_PWR_EnableBkUpAccess();
+  st = (RTCInt_Stats){0};
+
+  uint32_t sel = RCC->BDCR & RCC_BDCR_RTCSEL;
+  uint8_t  running = (RCC->BDCR & RCC_BDCR_RTCEN) && (RTC->ISR & RTC_ISR_INITS);
+
+  if (running && sel == RCC_BDCR_RTCSEL_0 && (RCC->BDCR & RCC_BDCR_LSERDY)){
+    src = RTCINT_SRC_LSE;
+  } else if (running && sel == RCC_BDCR_RTCSEL_1){
+    lsi_start();
+    src = RTCINT_SRC_LSI;
+  } else {
+    /* Not (validly) running. RTCSEL can only be changed after a backup
+       domain reset; backup SRAM is not part of it. */
+    if (sel){
+      RCC->BDCR |=  RCC_BDCR_BDRST;
+      RCC->BDCR &= ~RCC_BDCR_BDRST;
+    }
+    if (lse_start()){ src = RTCINT_SRC_LSE; RCC->BDCR |= RCC_BDCR_RTCSEL_0; }
+    else            { lsi_start(); src = RTCINT_SRC_LSI; RCC->BDCR |= RCC_BDCR_RTCSEL_1; }
+    RCC->BDCR |= RCC_BDCR_RTCEN;
+    running = 0;
+  }
+
+  uint32_t now = HAL_GetTick();
+  seed_t0 = now;
+  sync_t0 = now;
+  if (running){
+    cross_check(now);                          /* survived the reset: verify only */
+  } else if (seed_from_ds1307() != HAL_OK){
+    st.sync_errors++;
+    (void)cal_write(0u, 0x2101u);              /* 00:00:00, Mon 2000-01-01 */
+    sync_t0 = now - RTCINT_SYNC_PERIOD_MS + 10000u;   /* retry in 10 s */
+  }
+}
+
+uint8_t RTCInt_Source(void){ return src; }
+
+void RTCInt_GetTime(DS1307_Time *t){
+  uint32_t tr = RTC->TR;
+  (void)RTC->DR;                               /* TR read locks DR until DR is read */
+  t->hours   = bcd_to_dec((tr >> 16) & 0x3Fu);
+  t->minutes = bcd_to_dec((tr >> 8)  & 0x7Fu);
+  t->seconds = bcd_to_dec(tr & 0x7Fu);
+}
+
+uint32_t RTCInt_GetDate(void){
+  return RTC->DR & (RTC_DR_YT | RTC_DR_YU | RTC_DR_MT | RTC_DR_MU | RTC_DR_DT | RTC_DR_DU);
+}
+
+HAL_StatusTypeDef RTCInt_SetTime(const DS1307_Time *t){
+  (void)RTC->TR;                               /* unlock shadow DR, keep date */
+  return cal_write(tr_from(t), RTC->DR);
+}
+
+HAL_StatusTypeDef RTCInt_SetTimeBoth(const DS1307_Time *t){
+  HAL_StatusTypeDef s = RTCInt_SetTime(t);
+  HAL_StatusTypeDef d = DS1307_WriteTime(t);
+  seed_t0 = HAL_GetTick();
+  return (s != HAL_OK) ? s : d;
+}
+
+void RTCInt_Service(uint32_t now_ms){
+  if (now_ms - sync_t0 < RTCINT_SYNC_PERIOD_MS) return;
+  sync_t0 = now_ms;
+  cross_check(now_ms);
+}
+
+void RTCInt_SetAlarm(uint8_t h, uint8_t m, uint8_t s){
+  wp_unlock();
+  RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+  if (spin(&RTC->ISR, RTC_ISR_ALRAWF)){
+    RTC->ALRMAR = RTC_ALRMAR_MSK4 |            /* any date: daily */
+                  (dec_to_bcd(h) << 16) | (dec_to_bcd(m) << 8) | dec_to_bcd(s);
+    isr_clear(RTC_ISR_ALRAF);
+    RTC->CR |= RTC_CR_ALRAE | RTC_CR_ALRAIE;
+  }
+  wp_lock();
+  exti_rising(EXTI_ALARM, RTC_Alarm_IRQn);
+}
+
+void RTCInt_ClearAlarm(void){
+  wp_unlock();
+  RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+  wp_lock();
+  EXTI->IMR &= ~EXTI_ALARM;
+}
+
+void RTCInt_SetWakeup(uint32_t seconds){
+  if (seconds > 65536u) seconds = 65536u;
+  wp_unlock();
+  RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+  if (seconds && spin(&RTC->ISR, RTC_ISR_WUTWF)){
+    RTC->WUTR = seconds - 1u;
+    RTC->CR   = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUCKSEL_2;  /* ck_spre, 1 Hz */
+    isr_clear(RTC_ISR_WUTF);
+    RTC->CR  |= RTC_CR_WUTE | RTC_CR_WUTIE;
+  }
+  wp_lock();
+  if (seconds) exti_rising(EXTI_WAKEUP, RTC_WKUP_IRQn);
+  else         EXTI->IMR &= ~EXTI_WAKEUP;
+}
+
+void RTCInt_GetStats(RTCInt_Stats *out){
+  if (out) *out = st;
+}
+
+/* ====== IRQ ====== */
+void RTCInt_AlarmIRQ(void){
+  if (RTC->ISR & RTC_ISR_ALRAF){
+    isr_clear(RTC_ISR_ALRAF);
+    st.alarms++;
+    EventBus_Publish(EVT_RTC_ALARM, st.alarms);
+  }
+  EXTI->PR = EXTI_ALARM;
+}
+
+void RTCInt_WakeupIRQ(void){
+  if (RTC->ISR & RTC_ISR_WUTF){
+    isr_clear(RTC_ISR_WUTF);
+    st.wakeups++;
+    EventBus_Publish(EVT_RTC_WAKEUP, st.wakeups);
+  }
+  EXTI->PR = EXTI_WAKEUP;
+}
@@ -0,0 +1,153 @@
+#include "sensor_stats.h"
+#include <math.h>
+#include <stddef.h>
+
+#define EWMA_FAST_SHIFT   4u           /* alpha 1/16  */
+#define EWMA_SLOW_SHIFT   8u           /* alpha 1/256 */
+
+static const uint16_t depth[STAT_LEVEL_COUNT] = { STATS_MINUTES, STATS_HOURS, STATS_DAYS };
+
+static Stat_Acc ring_m[STAT_CH_COUNT][STATS_MINUTES];
+static Stat_Acc ring_h[STAT_CH_COUNT][STATS_HOURS];
+static Stat_Acc ring_d[STAT_CH_COUNT][STATS_DAYS];
+static Stat_Acc open_acc[STAT_CH_COUNT][STAT_LEVEL_COUNT];
+
+static uint16_t head[STAT_LEVEL_COUNT];    /* next slot to write            */
+static uint16_t fill[STAT_LEVEL_COUNT];    /* closed buckets kept           */
+
+static float    ewma[STAT_CH_COUNT][2];
+static uint8_t  ewma_seeded[STAT_CH_COUNT];
+
+static uint8_t  last_h, last_m, have_time;
+static uint32_t day_date;                  /* RTC date of the open day bucket */
+
+/* ====== Accumulator ====== */
+void StatAcc_Reset(Stat_Acc *a){
+  a->n = 0; a->mean = 0.0f; a->m2 = 0.0f; a->min = 0.0f; a->max = 0.0f;
+}
+
+void StatAcc_Add(Stat_Acc *a, float x){
+  if (a->n == 0u){ a->min = x; a->max = x; }
+  else { if (x < a->min) a->min = x; if (x > a->max) a->max = x; }
+  a->n++;
+  float d = x - a->mean;
+  a->mean += d / (float)a->n;
+  a->m2   += d * (x - a->mean);
+}
+
+void StatAcc_Merge(Stat_Acc *a, const Stat_Acc *b){
+  if (b->n == 0u) return;
+  if (a->n == 0u){ *a = *b; return; }
+  float na = (float)a->n, nb = (float)b->n, n = na + nb;
+  float d  = b->mean - a->mean;
+  a->mean += d * nb / n;
+  a->m2   += b->m2 + d * d * na * nb / n;
+  if (b->min < a->min) a->min = b->min;
+  if (b->max > a->max) a->max = b->max;
+  a->n += b->n;
+}
+
+void StatAcc_Summary(const Stat_Acc *a, Stat_Summary *out){
+  out->n      = a->n;
+  out->mean   = a->mean;
+  out->stddev = (a->n > 1u) ? sqrtf(a->m2 / (float)(a->n - 1u)) : 0.0f;
+  out->min    = a->min;
+  out->max    = a->max;
+}
+
+/* ====== Rings ====== */
+static Stat_Acc *slot(Stat_Channel ch, Stat_Level lvl, uint16_t i){
+  switch (lvl){
+    case STAT_MINUTE: return &ring_m[ch][i];
+    case STAT_HOUR:   return &ring_h[ch][i];
+    default:          return &ring_d[ch][i];
+  }
+}
+
+/* age 1 = newest closed bucket */
+static Stat_Acc *closed(Stat_Channel ch, Stat_Level lvl, uint16_t age){
+  if (age == 0u || age > fill[lvl]) return NULL;
+  uint16_t i = (uint16_t)((head[lvl] + depth[lvl] - age) % depth[lvl]);
+  return slot(ch, lvl, i);
+}
+
+static void close_level(Stat_Level lvl){
+  for (uint32_t ch = 0; ch < STAT_CH_COUNT; ch++){
+    *slot((Stat_Channel)ch, lvl, head[lvl]) = open_acc[ch][lvl];
+    StatAcc_Reset(&open_acc[ch][lvl]);
+  }
+  head[lvl] = (uint16_t)((head[lvl] + 1u) % depth[lvl]);
+  if (fill[lvl] < depth[lvl]) fill[lvl]++;
+}
+
+/* ====== API ====== */
+void Stats_Init(void){
+  for (uint32_t ch = 0; ch < STAT_CH_COUNT; ch++){
+    for (uint32_t l = 0; l < STAT_LEVEL_COUNT; l++) StatAcc_Reset(&open_acc[ch][l]);
+    ewma_seeded[ch] = 0;
+  }
+  for (uint32_t l = 0; l < STAT_LEVEL_COUNT; l++){ head[l] = 0; fill[l] = 0; }
+  have_time = 0;
+}
+
+void Stats_Add(Stat_Channel ch, float x){
+  if (ch >= STAT_CH_COUNT) return;
+  for (uint32_t l = 0; l < STAT_LEVEL_COUNT; l++) StatAcc_Add(&open_acc[ch][l], x);
+
+  if (!ewma_seeded[ch]){ ewma[ch][0] = ewma[ch][1] = x; ewma_seeded[ch] = 1; return; }
+  ewma[ch][0] += (x - ewma[ch][0]) / (float)(1u << EWMA_FAST_SHIFT);
+  ewma[ch][1] += (x - ewma[ch][1]) / (float)(1u << EWMA_SLOW_SHIFT);
+}
+
+/* Boundaries follow the calendar; a time set in SETUP closes the open
+   buckets early rather than back-filling skipped ones. */
+uint8_t Stats_Service(const DS1307_Time *now, uint32_t date){
+  if (!have_time){
+    last_h = now->hours; last_m = now->minutes; day_date = date; have_time = 1;
+    return 0;
+  }
+  uint8_t done = Stats_EndDay(date) ? (uint8_t)(1u << STAT_DAY) : 0u;
+  if (now->minutes == last_m && now->hours == last_h) return done;
+
+  done |= 1u << STAT_MINUTE;
+  close_level(STAT_MINUTE);
+  if (now->hours != last_h){
+    close_level(STAT_HOUR);
+    done |= 1u << STAT_HOUR;
+  }
+  last_h = now->hours;
+  last_m = now->minutes;
+  return done;
+}
+
+uint8_t Stats_EndDay(uint32_t date){
+  if (!have_time || date == day_date) return 0;   /* same calendar day: already closed */
+  close_level(STAT_DAY);
+  day_date = date;
+  return 1;
+}
+
+uint8_t Stats_Window(Stat_Channel ch, Stat_Level lvl, uint16_t count, Stat_Summary *out){
+  if (ch >= STAT_CH_COUNT || lvl >= STAT_LEVEL_COUNT || count == 0u) return 0;
+  Stat_Acc acc = open_acc[ch][lvl];
+  for (uint16_t age = 1; age < count; age++){
+    const Stat_Acc *b = closed(ch, lvl, age);
+    if (!b) break;
+    StatAcc_Merge(&acc, b);
+  }
+  if (out) StatAcc_Summary(&acc, out);
+  return (uint8_t)(acc.n != 0u);
+}
+
+uint8_t Stats_Bucket(Stat_Channel ch, Stat_Level lvl, uint16_t age, Stat_Acc *out){
+  if (ch >= STAT_CH_COUNT || lvl >= STAT_LEVEL_COUNT) return 0;
+  const Stat_Acc *b = closed(ch, lvl, age);
+  if (!b) return 0;
+  if (out) *out = *b;
+  return 1;
+}
+
+float Stats_Ewma(Stat_Channel ch, uint8_t slow){
+  if (ch >= STAT_CH_COUNT) return 0.0f;
+  return ewma[ch][slow ? 1 : 0];
+}
@@ -1,15 +1,88 @@
 #include "sensors_lm75.h"
 #include "i2c_sw.h"
+#include "i2c_dma.h"
+
+/* LM75 never stretches SCL, so zone polls can use the Timer+DMA engine */
+#if I2C_DMA_ENABLE
+#define LM75_BUS_READ      I2CDMA_Read
+#define LM75_BUS_MEM_READ  I2CDMA_Mem_Read
+#else
+#define LM75_BUS_READ      SWI2C_Read
+#define LM75_BUS_MEM_READ  SWI2C_Mem_Read
+#endif
+
+/* ---- Zone table ---- */
+static LM75_Dev zones[LM75_MAX_ZONES];
+static float    zone_c[LM75_MAX_ZONES];
+static uint8_t  zone_n = 0;
 
 /* LM75: 9-bit two's complement, left-justified; 0.125°C/LSB */
+static float lm75_decode(const uint8_t *buf){
+  int16_t raw = (int16_t)((buf[0] << 8) | buf[1]);
+  raw >>= 5;                                 /* align 9-bit; keeps sign */
+  if (raw & 0x0400) raw |= 0xF800;           /* sign-extend (safety) */
+  return (float)raw * 0.125f;
+}
+
+void LM75_InitDev(LM75_Dev *d, uint8_t addr7){
+  d->addr8    = (uint8_t)(addr7 << 1);
+  d->ptr_temp = 0;
+  d->ok       = 0;
+  d->c        = 0.0f;
+}
+
+/* The pointer register survives between reads, so after the first full
+ * Mem_Read a poll is just addr+R and two data bytes. */
+HAL_StatusTypeDef LM75_Read(LM75_Dev *d){
+  uint8_t buf[2] = {0};
+  HAL_StatusTypeDef st;
+  if (d->ptr_temp) st = LM75_BUS_READ(d->addr8, buf, 2);
+  else             st = LM75_BUS_MEM_READ(d->addr8, LM75_REG_TEMP, buf, 2);
+
+  d->ok       = (st == HAL_OK);
+  d->ptr_temp = d->ok;                       /* after any error, re-point next time */
+  if (d->ok) d->c = lm75_decode(buf);
+  return st;
+}
+
+uint8_t LM75_Discover(void){
+  zone_n = 0;
+  for (uint8_t a = LM75_ADDR7_FIRST; a < LM75_ADDR7_FIRST + LM75_MAX_ZONES; a++){
+    SWI2C_SetDeviceSpeed(a, SWI2C_FAST);    /* LM75 is specified to 400 kHz */
+    if (!SWI2C_Scan_One(a)) continue;
+    LM75_InitDev(&zones[zone_n], a);
+    (void)LM75_Read(&zones[zone_n]);         /* sets the pointer, primes zone_c */
+    zone_c[zone_n] = zones[zone_n].c;
+    zone_n++;
+  }
+  return zone_n;
+}
+
+uint8_t LM75_PollAll(void){
+  uint8_t good = 0;
+  for (uint8_t i = 0; i < zone_n; i++){
+    if (LM75_Read(&zones[i]) == HAL_OK){ zone_c[i] = zones[i].c; good++; }
+  }
+  return good;
+}
+
+uint8_t      LM75_ZoneCount(void)         { return zone_n; }
+const float *LM75_ZoneTemps(void)         { return zone_c; }
+uint8_t      LM75_ZoneOk(uint8_t zone)    { return (zone < zone_n) ? zones[zone].ok : 0; }
+uint8_t      LM75_ZoneAddr7(uint8_t zone) { return (zone < zone_n) ? (uint8_t)(zones[zone].addr8 >> 1) : 0; }
+
 HAL_StatusTypeDef LM75_ReadCelsius(float *out_c){
+  if (zone_n){
+    HAL_StatusTypeDef st = LM75_Read(&zones[0]);
+    if (st != HAL_OK) return st;
+    zone_c[0] = zones[0].c;
+    *out_c = zones[0].c;
+    return HAL_OK;
+  }
+
   uint8_t buf[2] = {0};
   HAL_StatusTypeDef st = SWI2C_Mem_Read(LM75_I2C_ADDR8, LM75_REG_TEMP, buf, 2);
   if (st != HAL_OK) return st;
-
-  int16_t raw = (int16_t)((buf[0] << 8) | buf[1]);
-  raw >>= 5;                                 /* align 9-bit; keeps sign */
-  if (raw & 0x0400) raw |= 0xF800;           /* sign-extend (safety) */
-  *out_c = (float)raw * 0.125f;
+  *out_c = lm75_decode(buf);
   return HAL_OK;
 }
@@ -0,0 +1,133 @@
+#include "soil.h"
+#include "adc.h"
+#include "tim.h"
+#include "light_capture.h"
+#include "event_bus.h"
+
+/* ====== Buffers ====== */
+#define SOIL_HALF_LEN  (SOIL_SCANS_PER_HALF * SOIL_PROBES)
+
+static uint16_t dma_buf[2u * SOIL_HALF_LEN];    /* ping-pong, filled by DMA2 S2 */
+
+static volatile uint8_t  ready_half = 0xFF;     /* 0/1 = half waiting, 0xFF = none */
+static volatile uint32_t half_seq   = 0;
+static volatile uint32_t missed     = 0;        /* ISR only: halves never picked up */
+static uint32_t torn    = 0;                    /* main only: halves overwritten while copied */
+static uint8_t  running = 0;
+static uint8_t  first_b = 0;                    /* 1 = scan 0 of each half is phase B */
+
+static Soil_Cal cal[SOIL_PROBES] = {
+  [0 ... SOIL_PROBES - 1u] = { SOIL_RESISTIVE, 58982u, 16384u, 400u }  /* 0.90 / 0.25 -> 40 % */
+};
+static int32_t  x_filt[SOIL_PROBES];
+static Soil_Result res;
+static uint8_t  have_res = 0;
+
+#define EXC_A_HIGH()  ((GPIOB->IDR & GPIO_PIN_10) != 0u)
+
+/* ====== DMA half/full (ADC2 regular group, routed from adc.c) ====== */
+void Soil_OnDma(uint8_t half){
+  if (ready_half != 0xFF) missed++;            /* previous half never picked up */
+  ready_half = half; half_seq++;
+  EventBus_Publish(EVT_SOIL_BLOCK, half);
+}
+
+/* ====== Control ====== */
+HAL_StatusTypeDef Soil_Start(void){
+  if (running) return HAL_OK;
+
+  if (HAL_TIM_OC_Start(&htim2, TIM_CHANNEL_3) != HAL_OK) return HAL_ERROR;
+  if (HAL_TIM_OC_Start(&htim2, TIM_CHANNEL_4) != HAL_OK) return HAL_ERROR;
+  if (HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_2) != HAL_OK) return HAL_ERROR;
+
+  /* Phase lock: arm the ADC after this period's CC2 trigger has passed and
+     well before the next update, so the first scan lands in the next
+     period, whose polarity is the opposite of what PB10 shows now. */
+  uint32_t arr = __HAL_TIM_GET_AUTORELOAD(&htim2);
+  HAL_StatusTypeDef st;
+  __disable_irq();
+  for (;;){
+    uint32_t cnt = __HAL_TIM_GET_COUNTER(&htim2);
+    if (cnt >= arr * 55u / 100u && cnt <= arr * 80u / 100u) break;
+  }
+  first_b    = (uint8_t)EXC_A_HIGH();
+  ready_half = 0xFF;
+  st = HAL_ADC_Start_DMA(&hadc2, (uint32_t *)dma_buf, 2u * SOIL_HALF_LEN);
+  __enable_irq();
+  if (st != HAL_OK){ Soil_Stop(); return HAL_ERROR; }
+
+  running  = 1;
+  have_res = 0;
+  return HAL_OK;
+}
+
+void Soil_Stop(void){
+  HAL_ADC_Stop_DMA(&hadc2);
+  HAL_TIM_PWM_Stop(&htim2, TIM_CHANNEL_2);
+  HAL_TIM_OC_Stop(&htim2, TIM_CHANNEL_4);       /* outputs float: no DC on probes */
+  HAL_TIM_OC_Stop(&htim2, TIM_CHANNEL_3);
+  if (LightCap_Running()) __HAL_TIM_ENABLE(&htim2);  /* HAL stops the counter with the last channel */
+  running    = 0;
+  ready_half = 0xFF;
+}
+
+void Soil_SetCal(uint8_t probe, const Soil_Cal *c){
+  if (probe < SOIL_PROBES && c) cal[probe] = *c;
+}
+
+uint8_t Soil_Get(Soil_Result *out){
+  if (!have_res) return 0;
+  if (out){ *out = res; out->overruns = missed + torn; }
+  return 1;
+}
+
+/* ====== Block processing ====== */
+static uint16_t to_vwc(const Soil_Cal *c, uint16_t x){
+  int32_t span = (int32_t)c->x_wet - (int32_t)c->x_dry;
+  if (span == 0) return 0;
+  int32_t v = ((int32_t)x - (int32_t)c->x_dry) * (int32_t)c->vwc_wet_x10 / span;
+  if (v < 0)    v = 0;
+  if (v > 1000) v = 1000;
+  return (uint16_t)v;
+}
+
+uint8_t Soil_Process(void){
+  if (ready_half == 0xFF) return 0;
+
+  uint32_t seq = half_seq;
+  const uint16_t *src = &dma_buf[ready_half ? SOIL_HALF_LEN : 0u];
+  ready_half = 0xFF;
+
+  /* per probe: sum of phase-A scans and of phase-B scans */
+  uint32_t sa[SOIL_PROBES] = {0}, sb[SOIL_PROBES] = {0};
+  for (uint16_t k = 0; k < SOIL_SCANS_PER_HALF; k++){
+    uint32_t *acc = ((k & 1u) ^ first_b) ? sb : sa;
+    for (uint8_t p = 0; p < SOIL_PROBES; p++) acc[p] += *src++;
+  }
+
+  /* DMA lapped us while summing: block may mix two passes */
+  if (half_seq != seq){ torn++; return 0; }
+
+  const uint32_t full = (SOIL_SCANS_PER_HALF / 2u) * 4095u;   /* vA + vB for an intact probe */
+  for (uint8_t p = 0; p < SOIL_PROBES; p++){
+    uint32_t sum = sa[p] + sb[p];
+    uint16_t x;
+    if (cal[p].kind == SOIL_RESISTIVE){
+      res.ok[p] = (uint8_t)(sum > full * 3u / 4u && sum < full * 5u / 4u);
+      x = sum ? (uint16_t)(((uint64_t)sa[p] * 65535u) / sum) : 0u;
+    } else {
+      res.ok[p] = 1;
+      x = (uint16_t)((sum * 16u) / SOIL_SCANS_PER_HALF);       /* mean counts << 4 */
+    }
+
+    if (!res.blocks) x_filt[p] = x;
+    else             x_filt[p] += ((int32_t)x - x_filt[p]) >> SOIL_AVG_SHIFT;
+
+    res.x[p]       = (uint16_t)x_filt[p];
+    res.vwc_x10[p] = res.ok[p] ? to_vwc(&cal[p], res.x[p]) : 0u;
+  }
+
+  res.blocks++;
+  have_res = 1;
+  return 1;
+}
@@ -0,0 +1,159 @@
+#include "timebase.h"
+
+static volatile uint32_t tb_hi = 0;          /* TIM5 wraps, upper 32 bits */
+static TB_Timer *head = NULL;                /* armed timers, soonest first */
+
+/* ====== Time ====== */
+uint32_t TB_Now(void){ return TIM5->CNT; }
+
+uint64_t TB_Now64(void){
+  uint32_t pm = __get_PRIMASK();
+  __disable_irq();
+  uint32_t hi = tb_hi;
+  uint32_t lo = TIM5->CNT;
+  if ((TIM5->SR & TIM_SR_UIF) && lo < 0x80000000u) hi++;   /* wrap not serviced yet */
+  __set_PRIMASK(pm);
+  return ((uint64_t)hi << 32) | lo;
+}
+
+void TB_DelayUs(uint32_t us){
+  uint32_t t0 = TIM5->CNT;
+  while ((TIM5->CNT - t0) < us) { __NOP(); }
+}
+
+/* ====== Timer list (caller masks interrupts) ====== */
+static void unlink(TB_Timer *t){
+  for (TB_Timer **pp = &head; *pp; pp = &(*pp)->next){
+    if (*pp == t){ *pp = t->next; break; }
+  }
+  t->armed = 0;
+}
+
+static void insert(TB_Timer *t){
+  uint32_t now = TIM5->CNT;
+  TB_Timer **pp = &head;
+  while (*pp && (int32_t)((*pp)->at - now) <= (int32_t)(t->at - now)) pp = &(*pp)->next;
+  t->next  = *pp;
+  *pp      = t;
+  t->armed = 1;
+}
+
+/* CC1 on the soonest expiry; if that is already past, raise CC1 by software
+   instead of waiting a full counter wrap for the match. */
+static void arm(void){
+  if (!head){ TIM5->DIER &= ~TIM_DIER_CC1IE; return; }
+  TIM5->CCR1  = head->at;
+  TIM5->DIER |= TIM_DIER_CC1IE;
+  if ((int32_t)(TIM5->CNT - head->at) >= 0) TIM5->EGR = TIM_EGR_CC1G;
+}
+
+static void run_due(void){
+  TB_Timer *t;
+  while ((t = head) != NULL && (int32_t)(TIM5->CNT - t->at) >= 0){
+    head = t->next;
+    if (t->period){ t->at += t->period; insert(t); }
+    else           t->armed = 0;
+    t->cb(t->ctx);
+  }
+  arm();
+}
+
+void TB_Start(TB_Timer *t, uint32_t at, uint32_t period_us, TB_Callback cb, void *ctx){
+  uint32_t pm = __get_PRIMASK();
+  __disable_irq();
+  if (t->armed) unlink(t);
+  t->at     = at;
+  t->period = period_us;
+  t->cb     = cb;
+  t->ctx    = ctx;
+  insert(t);
+  arm();
+  __set_PRIMASK(pm);
+}
+
+void TB_Stop(TB_Timer *t){
+  uint32_t pm = __get_PRIMASK();
+  __disable_irq();
+  if (t->armed){ unlink(t); arm(); }
+  __set_PRIMASK(pm);
+}
+
+/* ====== Sleep ====== */
+static void wake_cb(void *ctx){ (void)ctx; }
+
+void TB_SleepUntil(uint32_t deadline){
+  if (__get_IPSR() || __get_PRIMASK() || !NVIC_GetEnableIRQ(TIM5_IRQn)){
+    while (!TB_Expired(deadline)) { }        /* nothing would wake us */
+    return;
+  }
+  static TB_Timer wake;                      /* thread mode only: one user */
+  TB_Start(&wake, deadline, 0, wake_cb, NULL);
+  while (!TB_Expired(deadline)) __WFI();
+  TB_Stop(&wake);
+}
+
+void TB_IRQHandler(void){
+  uint32_t sr = TIM5->SR;
+  if (sr & TIM_SR_UIF){
+    /* Clear and count as one step: TB_Now64() in a preempting ISR must not
+       see the flag gone with the old tb_hi (a 2^32 us jump back). */
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    TIM5->SR = ~(uint32_t)TIM_SR_UIF;
+    tb_hi++;
+    __set_PRIMASK(pm);
+  }
+  if (sr & TIM_SR_CC1IF){ TIM5->SR = ~(uint32_t)TIM_SR_CC1IF; run_due(); }
+}
+
+/* ====== HAL time base overrides ====== */
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority){
+  if (TickPriority >= (1UL << __NVIC_PRIO_BITS)) return HAL_ERROR;
+  uwTickPrio = TickPriority;
+  SysTick->CTRL = 0;                         /* no 1 kHz tick interrupt */
+
+  __HAL_RCC_TIM5_CLK_ENABLE();
+  uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+  uint32_t clk   = ((RCC->CFGR & RCC_CFGR_PPRE1) == 0) ? pclk1 : 2U * pclk1;
+  uint32_t psc   = clk / 1000000U - 1U;
+
+  if (!(TIM5->CR1 & TIM_CR1_CEN)){
+    TIM5->CR1  = TIM_CR1_URS;                /* UG does not count as a wrap */
+    TIM5->ARR  = 0xFFFFFFFFu;
+    TIM5->PSC  = psc;
+    TIM5->EGR  = TIM_EGR_UG;
+    TIM5->CNT  = 0;
+    TIM5->SR   = 0;
+    TIM5->DIER = TIM_DIER_UIE;
+    TIM5->CR1 |= TIM_CR1_CEN;
+  } else if (TIM5->PSC != psc){
+    /* Clock change: load the prescaler now, not at the next wrap, and put
+       the count back (costs well under a microsecond) */
+    uint32_t cnt = TIM5->CNT;
+    TIM5->PSC = psc;
+    TIM5->EGR = TIM_EGR_UG;
+    TIM5->CNT = cnt;
+  }
+
+  HAL_NVIC_SetPriority(TIM5_IRQn, TickPriority, 0U);
+  HAL_NVIC_EnableIRQ(TIM5_IRQn);
+  return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void){
+  return (uint32_t)(TB_Now64() / 1000U);
+}
+
+void HAL_Delay(uint32_t Delay){
+  uint64_t end = TB_Now64() + (uint64_t)Delay * 1000U;
+  for (;;){
+    uint64_t now = TB_Now64();
+    if (now >= end) break;
+    uint64_t left = end - now;
+    if (left > 0x40000000u) left = 0x40000000u;   /* keep 32-bit deadlines in range */
+    TB_SleepUntil((uint32_t)now + (uint32_t)left);
+  }
+}
+
+void HAL_SuspendTick(void){ HAL_NVIC_DisableIRQ(TIM5_IRQn); }
+void HAL_ResumeTick(void) { HAL_NVIC_EnableIRQ(TIM5_IRQn); }
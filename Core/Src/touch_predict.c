@@ -0,0 +1,91 @@
+#include "touch_predict.h"
+#include <math.h>
+
+/* ====== Per-axis alpha-beta-gamma step ====== */
+static float axis_step(TP_Axis *ax, float z, float dt){
+    float pp = ax->p + ax->v * dt + 0.5f * ax->a * dt * dt;
+    float vp = ax->v + ax->a * dt;
+    float r  = z - pp;                              /* innovation */
+
+    ax->p = pp + TP_ALPHA * r;
+    ax->v = vp + TP_BETA  * r / dt;
+    ax->a = ax->a + 2.0f * TP_GAMMA * r / (dt * dt);
+    return r;
+}
+
+static void axis_reset(TP_Axis *ax, float z){
+    ax->p = z; ax->v = 0.f; ax->a = 0.f;
+}
+
+void TouchPredict_Init(TouchPredictor *tp, uint16_t screen_w, uint16_t screen_h){
+    tp->max_x      = (uint16_t)(screen_w ? screen_w - 1 : 0);
+    tp->max_y      = (uint16_t)(screen_h ? screen_h - 1 : 0);
+    tp->latency_ms = 16.0f;     /* ~ one loop + one redraw until measured */
+    TouchPredict_Reset(tp, 0, 0, 0);
+}
+
+void TouchPredict_Reset(TouchPredictor *tp, uint16_t x, uint16_t y, uint32_t now_ms){
+    axis_reset(&tp->x, (float)x);
+    axis_reset(&tp->y, (float)y);
+    tp->t_last     = now_ms;
+    tp->n          = 1;
+    tp->lead_scale = 0.f;
+}
+
+void TouchPredict_Update(TouchPredictor *tp, uint16_t x, uint16_t y, uint32_t now_ms){
+    uint32_t dt_ms = now_ms - tp->t_last;
+    if(dt_ms == 0) return;                          /* same tick: nothing new */
+    if(tp->n == 0 || dt_ms > TP_MAX_DT_MS){         /* stale track: restart */
+        TouchPredict_Reset(tp, x, y, now_ms);
+        return;
+    }
+
+    float dt = (float)dt_ms;
+    float rx = axis_step(&tp->x, (float)x, dt);
+    float ry = axis_step(&tp->y, (float)y, dt);
+    tp->t_last = now_ms;
+    if(tp->n < 255) tp->n++;
+
+    /* ---- overshoot limiter ---- */
+    float vx = tp->x.v, vy = tp->y.v;
+    float speed2 = vx * vx + vy * vy;
+
+    if(speed2 < TP_STOP_SPEED * TP_STOP_SPEED){
+        tp->lead_scale = 0.f;                       /* finger parked: no lead */
+        tp->x.a = tp->y.a = 0.f;                    /* and no stale accel */
+    } else if(rx * vx + ry * vy < 0.f){
+        tp->lead_scale *= 0.5f;                     /* sample behind prediction */
+    } else {
+        tp->lead_scale += 0.25f * (1.0f - tp->lead_scale);
+    }
+}
+
+void TouchPredict_AddLatency(TouchPredictor *tp, float latency_ms){
+    if(latency_ms < 0.f) return;
+    tp->latency_ms += 0.125f * (latency_ms - tp->latency_ms); /* EMA, 1/8 */
+}
+
+static uint16_t clamp_px(float v, uint16_t max){
+    if(v < 0.f)          return 0;
+    if(v > (float)max)   return max;
+    return (uint16_t)(v + 0.5f);
+}
+
+void TouchPredict_Get(const TouchPredictor *tp, uint16_t *x, uint16_t *y){
+    float dx = 0.f, dy = 0.f;
+
+    if(tp->n >= 3 && tp->lead_scale > 0.f){         /* need a velocity estimate */
+        float L = tp->latency_ms;
+        dx = (tp->x.v * L + 0.5f * tp->x.a * L * L) * tp->lead_scale;
+        dy = (tp->y.v * L + 0.5f * tp->y.a * L * L) * tp->lead_scale;
+
+        float d2 = dx * dx + dy * dy;
+        if(d2 > TP_MAX_LEAD_PX * TP_MAX_LEAD_PX){   /* cap lead, keep direction */
+            float k = TP_MAX_LEAD_PX / sqrtf(d2);
+            dx *= k; dy *= k;
+        }
+    }
+
+    if(x) *x = clamp_px(tp->x.p + dx, tp->max_x);
+    if(y) *y = clamp_px(tp->y.p + dy, tp->max_y);
+}
@@ -0,0 +1,29 @@
+#include "touch_sm.h"
+
+void TouchSM_Reset(TouchSM *sm){
+    sm->down   = 0;
+    sm->x      = sm->y  = 0;
+    sm->x0     = sm->y0 = 0;
+    sm->t_down = sm->t_last = 0;
+}
+
+TouchEvent TouchSM_Update(TouchSM *sm, uint8_t pressed,
+                          uint16_t x, uint16_t y, uint32_t now_ms){
+    if(pressed){
+        sm->x = x; sm->y = y;
+        sm->t_last = now_ms;
+        if(!sm->down){
+            sm->down   = 1;
+            sm->x0     = x; sm->y0 = y;
+            sm->t_down = now_ms;
+            return TOUCH_EV_DOWN;
+        }
+        return TOUCH_EV_HOLD;
+    }
+
+    if(sm->down){
+        sm->down = 0;            /* x/y keep the last valid position */
+        return TOUCH_EV_UP;
+    }
+    return TOUCH_EV_NONE;
+}
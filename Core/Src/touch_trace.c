@@ -0,0 +1,65 @@
+#include "touch_trace.h"
+#include "xpt2046.h"
+#include "integrity.h"
+#include "timebase.h"
+#include <stdio.h>
+
+/* ====== Storage ====== */
+static TouchTraceSample tt_buf[TOUCH_TRACE_DEPTH];
+static uint16_t tt_count  = 0;
+static uint8_t  tt_active = 0;
+
+/* ====== µs timestamp: TIM5 timebase, relative to TouchTrace_Start ====== */
+static uint32_t tt_t0 = 0;
+
+void TouchTrace_Start(void){
+    tt_count  = 0;
+    tt_t0     = TB_Now();
+    tt_active = 1;
+}
+
+void     TouchTrace_Stop(void)  { tt_active = 0; }
+uint8_t  TouchTrace_Active(void){ return tt_active; }
+uint8_t  TouchTrace_Full(void)  { return (uint8_t)(tt_count >= TOUCH_TRACE_DEPTH); }
+uint16_t TouchTrace_Count(void) { return tt_count; }
+
+const TouchTraceSample *TouchTrace_Get(uint16_t i){
+    return (i < tt_count) ? &tt_buf[i] : NULL;
+}
+
+void TouchTrace_Record(uint8_t flags, uint8_t idx,
+                       uint16_t x, uint16_t y, uint16_t z1, uint16_t z2){
+    if(!tt_active) return;
+    if(tt_count >= TOUCH_TRACE_DEPTH){ tt_active = 0; return; } /* one-shot */
+
+    TouchTraceSample *s = &tt_buf[tt_count++];
+    s->t_us  = TB_Now() - tt_t0;
+    s->x     = x;  s->y  = y;
+    s->z1    = z1; s->z2 = z2;
+    s->flags = flags;
+    s->idx   = idx;
+    s->rsv   = 0;
+}
+
+void TouchTrace_Dump(void){
+    int32_t xmin, xmax, ymin, ymax;
+    XPT_GetCalibration(&xmin, &xmax, &ymin, &ymax);
+
+    printf("# touch-trace v2 n=%u cal=%ld,%ld,%ld,%ld\r\n",
+           (unsigned)tt_count, (long)xmin, (long)xmax, (long)ymin, (long)ymax);
+    char line[64];
+    Integrity_Stream crc;                       /* over every line after the '#' header */
+    Integrity_StreamBegin(&crc);
+    int len = snprintf(line, sizeof(line), "t_us,flags,idx,x,y,z1,z2\r\n");
+    Integrity_StreamFeed(&crc, line, (uint32_t)len);
+    fputs(line, stdout);
+    for(uint16_t i = 0; i < tt_count; i++){
+        const TouchTraceSample *s = &tt_buf[i];
+        len = snprintf(line, sizeof(line), "%lu,%u,%u,%u,%u,%u,%u\r\n",
+                       (unsigned long)s->t_us, s->flags, s->idx,
+                       s->x, s->y, s->z1, s->z2);
+        Integrity_StreamFeed(&crc, line, (uint32_t)len);
+        fputs(line, stdout);
+    }
+    printf("# crc32=%08lX\r\n", (unsigned long)Integrity_StreamEnd(&crc));
+}
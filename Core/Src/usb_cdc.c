@@ -0,0 +1,312 @@
+#include "usb_cdc.h"
+#include "usb_fs.h"
+#include <stddef.h>
+
+#define RING_MASK   (USBCDC_RING_SIZE - 1u)
+
+/* ====== Descriptors ====== */
+#define USB_VID     0x0483u                     /* ST virtual COM port IDs */
+#define USB_PID     0x5740u
+
+static const uint8_t dev_desc[18] = {
+  18, 0x01, 0x00, 0x02,                         /* USB 2.0 */
+  0x02, 0x00, 0x00, USBFS_EP0_MPS,              /* CDC */
+  USB_VID & 0xFFu, USB_VID >> 8, USB_PID & 0xFFu, USB_PID >> 8,
+  0x00, 0x02, 1, 2, 3, 1
+};
+
+#define CFG_LEN  67u
+static const uint8_t cfg_desc[CFG_LEN] = {
+  9, 0x02, CFG_LEN, 0, 2, 1, 0, 0x80, 50,       /* bus powered, 100 mA */
+  /* interface 0: communication */
+  9, 0x04, 0, 0, 1, 0x02, 0x02, 0x01, 0,
+  5, 0x24, 0x00, 0x10, 0x01,                    /* header, CDC 1.10 */
+  5, 0x24, 0x01, 0x00, 1,                       /* call management */
+  4, 0x24, 0x02, 0x02,                          /* ACM: line coding + state */
+  5, 0x24, 0x06, 0, 1,                          /* union */
+  7, 0x05, 0x80 | USBFS_EP_NOTIFY, 0x03, USBFS_INT_MPS, 0, 16,
+  /* interface 1: data */
+  9, 0x04, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+  7, 0x05, USBFS_EP_BULK,        0x02, USBFS_BULK_MPS, 0, 0,
+  7, 0x05, 0x80 | USBFS_EP_BULK, 0x02, USBFS_BULK_MPS, 0, 0
+};
+
+static const char *const str_ascii[] = { NULL, "STM32 Project", "Sensor Console" };
+static char    serial[25];                      /* unique ID, hex */
+static uint8_t str_buf[2 + 2 * 32];
+
+/* ====== State ====== */
+typedef struct {
+  const uint8_t *p;
+  uint32_t       len;
+  USBCDC_Done    done;
+  void          *ctx;
+} Seg;
+
+enum { SRC_NONE = 0, SRC_SEG, SRC_RING, SRC_ZLP };
+
+static Seg               q[USBCDC_TXQ_DEPTH];
+static volatile uint32_t q_head = 0;            /* main               */
+static volatile uint32_t q_tail = 0;            /* USB interrupt      */
+static uint32_t          seg_off = 0;
+
+static uint8_t           ring[USBCDC_RING_SIZE];
+static volatile uint32_t r_head = 0;            /* main               */
+static volatile uint32_t r_tail = 0;            /* USB interrupt      */
+
+static volatile uint8_t  tx_src = SRC_NONE;
+static uint32_t          tx_len = 0;
+static uint8_t           tx_zlp = 0;
+
+static volatile uint8_t  configured = 0, dtr = 0, suspended = 0;
+static uint8_t           config_val = 0;
+static uint8_t           line_coding[7] = { 0x00, 0xC2, 0x01, 0x00, 0, 0, 8 };   /* 115200 8N1 */
+static uint8_t           ep0_buf[8];
+static uint8_t           ep0_pending = 0;       /* class request awaiting its data stage */
+static uint8_t           ep0_zlp = 0;
+
+static uint8_t           rx_buf[USBFS_BULK_MPS];
+static USBCDC_Rx         rx_fn = NULL;
+
+static USBCDC_Stats      st;
+
+/* ====== Transmit engine (USB interrupt, or main with the IRQ locked) ====== */
+static void tx_kick(void){
+  if (tx_src != SRC_NONE || !configured) return;
+
+  if (q_tail != q_head){
+    const Seg *s = &q[q_tail % USBCDC_TXQ_DEPTH];
+    uint32_t n = s->len - seg_off;
+    if (n > USBFS_XFER_MAX) n = USBFS_XFER_MAX;
+    tx_src = SRC_SEG; tx_len = n;
+    USBFS_EpIn(USBFS_EP_BULK, s->p + seg_off, n);
+  } else if (r_head != r_tail){
+    uint32_t t = r_tail & RING_MASK;
+    uint32_t n = r_head - r_tail;
+    if (n > USBCDC_RING_SIZE - t) n = USBCDC_RING_SIZE - t;   /* contiguous part */
+    tx_src = SRC_RING; tx_len = n;
+    USBFS_EpIn(USBFS_EP_BULK, &ring[t], n);
+  } else if (tx_zlp){
+    tx_zlp = 0;                                 /* last transfer ended on a packet boundary */
+    tx_src = SRC_ZLP; tx_len = 0;
+    USBFS_EpIn(USBFS_EP_BULK, NULL, 0);
+  }
+}
+
+static void tx_flush(void){
+  while (q_tail != q_head){
+    Seg *s = &q[q_tail % USBCDC_TXQ_DEPTH];
+    if (s->done) s->done(s->ctx);
+    q_tail++;
+  }
+  r_tail  = r_head;
+  seg_off = 0;
+  tx_src  = SRC_NONE;
+  tx_zlp  = 0;
+}
+
+static void bulk_in_done(void){
+  st.tx_bytes += tx_len;
+  st.tx_xfers++;
+  if (tx_src == SRC_SEG){
+    Seg *s = &q[q_tail % USBCDC_TXQ_DEPTH];
+    seg_off += tx_len;
+    if (seg_off >= s->len){
+      seg_off = 0;
+      if (s->done) s->done(s->ctx);
+      q_tail++;
+    }
+  } else if (tx_src == SRC_RING){
+    r_tail += tx_len;
+  }
+  tx_zlp = (uint8_t)(tx_len && (tx_len % USBFS_BULK_MPS) == 0u);
+  tx_src = SRC_NONE;
+  tx_kick();
+}
+
+/* ====== Control endpoint ====== */
+static void ep0_send(const void *p, uint32_t len, uint16_t w_len){
+  if (len > w_len) len = w_len;
+  ep0_zlp = (uint8_t)(len && len < w_len && (len % USBFS_EP0_MPS) == 0u);
+  USBFS_EpIn(0, p, len);
+}
+
+static void ep0_status(void){ USBFS_EpIn(0, NULL, 0); }
+
+static uint32_t string_desc(uint8_t idx){
+  if (idx == 0){
+    str_buf[0] = 4; str_buf[1] = 0x03; str_buf[2] = 0x09; str_buf[3] = 0x04;   /* en-US */
+    return 4;
+  }
+  const char *s = (idx == 3) ? serial : (idx < 3 ? str_ascii[idx] : NULL);
+  if (!s) return 0;
+  uint32_t n = 0;
+  for (; s[n] && n < 32u; n++){ str_buf[2 + 2 * n] = (uint8_t)s[n]; str_buf[3 + 2 * n] = 0; }
+  str_buf[0] = (uint8_t)(2 + 2 * n);
+  str_buf[1] = 0x03;
+  return str_buf[0];
+}
+
+static void std_request(const uint8_t *s, uint16_t w_val, uint16_t w_len){
+  switch (s[1]){
+    case 0x06: {                                /* GET_DESCRIPTOR */
+      uint8_t type = (uint8_t)(w_val >> 8);
+      if (type == 0x01)      ep0_send(dev_desc, sizeof(dev_desc), w_len);
+      else if (type == 0x02) ep0_send(cfg_desc, sizeof(cfg_desc), w_len);
+      else if (type == 0x03){
+        uint32_t n = string_desc((uint8_t)w_val);
+        if (n) ep0_send(str_buf, n, w_len); else USBFS_EpStall(0);
+      } else USBFS_EpStall(0);                  /* no qualifier: full speed only */
+    } break;
+    case 0x05:                                  /* SET_ADDRESS */
+      USBFS_SetAddress((uint8_t)(w_val & 0x7Fu));
+      ep0_status();
+      break;
+    case 0x09:                                  /* SET_CONFIGURATION */
+      config_val = (uint8_t)w_val;
+      tx_flush();
+      USBFS_Configure(config_val != 0u);
+      configured = (uint8_t)(config_val != 0u);
+      if (configured) USBFS_EpOut(USBFS_EP_BULK, rx_buf, sizeof(rx_buf));
+      ep0_status();
+      break;
+    case 0x08:                                  /* GET_CONFIGURATION */
+      ep0_buf[0] = config_val;
+      ep0_send(ep0_buf, 1, w_len);
+      break;
+    case 0x00:                                  /* GET_STATUS */
+      ep0_buf[0] = 0; ep0_buf[1] = 0;
+      ep0_send(ep0_buf, 2, w_len);
+      break;
+    case 0x0A:                                  /* GET_INTERFACE */
+      ep0_buf[0] = 0;
+      ep0_send(ep0_buf, 1, w_len);
+      break;
+    case 0x01: case 0x03: case 0x0B:            /* CLEAR/SET_FEATURE, SET_INTERFACE */
+      ep0_status();
+      break;
+    default:
+      USBFS_EpStall(0);
+      break;
+  }
+}
+
+static void class_request(const uint8_t *s, uint16_t w_val, uint16_t w_len){
+  switch (s[1]){
+    case 0x20:                                  /* SET_LINE_CODING: data stage first */
+      ep0_pending = 0x20;
+      USBFS_EpOut(0, line_coding, sizeof(line_coding));
+      break;
+    case 0x21:                                  /* GET_LINE_CODING */
+      ep0_send(line_coding, sizeof(line_coding), w_len);
+      break;
+    case 0x22:                                  /* SET_CONTROL_LINE_STATE */
+      dtr = (uint8_t)(w_val & 1u);              /* 0: new data is refused, queue drains */
+      ep0_status();
+      break;
+    case 0x23:                                  /* SEND_BREAK */
+      ep0_status();
+      break;
+    default:
+      USBFS_EpStall(0);
+      break;
+  }
+}
+
+/* ====== Endpoint layer callbacks ====== */
+void USBFS_OnReset(void){
+  configured = 0;
+  dtr        = 0;
+  config_val = 0;
+  ep0_pending = 0;
+  tx_flush();
+}
+
+void USBFS_OnSuspend(uint8_t s){ suspended = s; }
+
+void USBFS_OnSetup(const uint8_t s[8]){
+  uint16_t w_val = (uint16_t)(s[2] | (s[3] << 8));
+  uint16_t w_len = (uint16_t)(s[6] | (s[7] << 8));
+  ep0_pending = 0;
+  ep0_zlp     = 0;
+  switch ((s[0] >> 5) & 3u){
+    case 0:  std_request(s, w_val, w_len);   break;
+    case 1:  class_request(s, w_val, w_len); break;
+    default: USBFS_EpStall(0);               break;
+  }
+}
+
+void USBFS_OnInDone(uint8_t ep){
+  if (ep == USBFS_EP_BULK){ bulk_in_done(); return; }
+  if (ep == 0 && ep0_zlp){ ep0_zlp = 0; USBFS_EpIn(0, NULL, 0); }
+}
+
+void USBFS_OnOutDone(uint8_t ep, uint32_t len){
+  if (ep == 0){
+    if (ep0_pending == 0x20 && len >= sizeof(line_coding)){
+      st.baud = (uint32_t)line_coding[0] | ((uint32_t)line_coding[1] << 8) |
+                ((uint32_t)line_coding[2] << 16) | ((uint32_t)line_coding[3] << 24);
+      ep0_pending = 0;
+      ep0_status();
+    }
+    return;
+  }
+  if (ep == USBFS_EP_BULK){
+    st.rx_bytes += len;
+    if (rx_fn && len) rx_fn(rx_buf, len);
+    USBFS_EpOut(USBFS_EP_BULK, rx_buf, sizeof(rx_buf));
+  }
+}
+
+/* ====== API ====== */
+static void hex32(char *d, uint32_t v){
+  for (int i = 7; i >= 0; i--, v >>= 4) d[i] = "0123456789ABCDEF"[v & 0xFu];
+}
+
+void USBCDC_Init(void){
+  for (uint8_t i = 0; i < 3u; i++) hex32(&serial[8u * i], USBFS_UniqueId(i));
+  serial[24] = 0;
+  st = (USBCDC_Stats){0};
+  st.baud = 115200u;
+  USBFS_Init();
+}
+
+uint8_t USBCDC_Ready(void){ return (uint8_t)(configured && dtr && !suspended); }
+
+uint8_t USBCDC_Submit(const void *data, uint32_t len, USBCDC_Done done, void *ctx){
+  if (!USBCDC_Ready() || !len) return 0;
+  if (q_head - q_tail >= USBCDC_TXQ_DEPTH){ st.dropped += len; return 0; }
+  Seg *s = &q[q_head % USBCDC_TXQ_DEPTH];
+  s->p = (const uint8_t *)data; s->len = len; s->done = done; s->ctx = ctx;
+  __sync_synchronize();
+  q_head++;
+  USBFS_Lock();
+  tx_kick();
+  USBFS_Unlock();
+  return 1;
+}
+
+uint32_t USBCDC_Write(const void *data, uint32_t len){
+  if (!USBCDC_Ready()) return 0;
+  uint32_t room = USBCDC_RING_SIZE - (r_head - r_tail);
+  if (len > room){ st.dropped += len - room; len = room; }
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t h = r_head;
+  for (uint32_t i = 0; i < len; i++) ring[(h + i) & RING_MASK] = p[i];
+  __sync_synchronize();
+  r_head = h + len;
+  return len;
+}
+
+void USBCDC_Poll(void){
+  if (tx_src != SRC_NONE || (r_head == r_tail && !tx_zlp)) return;
+  USBFS_Lock();
+  tx_kick();
+  USBFS_Unlock();
+}
+
+void USBCDC_SetRxHandler(USBCDC_Rx fn){ rx_fn = fn; }
+
+void USBCDC_GetStats(USBCDC_Stats *out){
+  if (out) *out = st;
+}
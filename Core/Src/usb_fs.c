@@ -0,0 +1,273 @@
+#include "usb_fs.h"
+#include "main.h"
+
+/* ====== Register access ====== */
+#define OTG       USB_OTG_FS
+#define DEV       ((USB_OTG_DeviceTypeDef *)(USB_OTG_FS_PERIPH_BASE + USB_OTG_DEVICE_BASE))
+#define INEP(i)   ((USB_OTG_INEndpointTypeDef *)(USB_OTG_FS_PERIPH_BASE + USB_OTG_IN_ENDPOINT_BASE + (i) * USB_OTG_EP_REG_SIZE))
+#define OUTEP(i)  ((USB_OTG_OUTEndpointTypeDef *)(USB_OTG_FS_PERIPH_BASE + USB_OTG_OUT_ENDPOINT_BASE + (i) * USB_OTG_EP_REG_SIZE))
+#define FIFO(i)   (*(__IO uint32_t *)(USB_OTG_FS_PERIPH_BASE + USB_OTG_FIFO_BASE + (i) * USB_OTG_FIFO_SIZE))
+#define PCGCCTL   (*(__IO uint32_t *)(USB_OTG_FS_PERIPH_BASE + USB_OTG_PCGCCTL_BASE))
+
+#define EP_N        3u
+#define EP_INT_ALL  0xFB7Fu
+#define SPIN_MAX    200000u
+
+/* FIFO RAM is 320 words. EP1 holds 8 bulk packets, so the core can keep
+   answering IN tokens while the next half is refilled. */
+#define RX_FIFO_W   128u
+#define TX0_FIFO_W  32u
+#define TX1_FIFO_W  128u
+#define TX2_FIFO_W  16u
+
+#define PKTSTS_OUT_DATA    2u
+#define PKTSTS_SETUP_DATA  6u
+
+typedef struct { const uint8_t *p; uint32_t rem; uint16_t mps; } InState;
+typedef struct { uint8_t *p; uint32_t len, got; uint16_t mps; } OutState;
+
+static InState  in[EP_N]  = { { NULL, 0, USBFS_EP0_MPS }, { NULL, 0, USBFS_BULK_MPS }, { NULL, 0, USBFS_INT_MPS } };
+static OutState out[EP_N] = { { NULL, 0, 0, USBFS_EP0_MPS }, { NULL, 0, 0, USBFS_BULK_MPS }, { NULL, 0, 0, 0 } };
+static uint32_t setup_w[2];
+
+static void spin_clear(volatile uint32_t *reg, uint32_t mask){
+  for (uint32_t n = SPIN_MAX; n && (*reg & mask); n--) { }
+}
+
+static void flush_tx(uint32_t num){
+  OTG->GRSTCTL = USB_OTG_GRSTCTL_TXFFLSH | (num << USB_OTG_GRSTCTL_TXFNUM_Pos);
+  spin_clear(&OTG->GRSTCTL, USB_OTG_GRSTCTL_TXFFLSH);
+}
+
+static void flush_rx(void){
+  OTG->GRSTCTL = USB_OTG_GRSTCTL_RXFFLSH;
+  spin_clear(&OTG->GRSTCTL, USB_OTG_GRSTCTL_RXFFLSH);
+}
+
+/* EP0 OUT always accepts the next SETUP (3 back to back) or one packet. */
+static void ep0_arm(void){
+  OUTEP(0)->DOEPTSIZ = (3u << USB_OTG_DOEPTSIZ_STUPCNT_Pos) |
+                       (1u << USB_OTG_DOEPTSIZ_PKTCNT_Pos) | USBFS_EP0_MPS;
+  OUTEP(0)->DOEPCTL |= USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA;
+}
+
+/* ====== Init ====== */
+void USBFS_Init(void){
+  GPIO_InitTypeDef g = {0};
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+  g.Pin       = GPIO_PIN_11 | GPIO_PIN_12;   /* DM / DP */
+  g.Mode      = GPIO_MODE_AF_PP;
+  g.Pull      = GPIO_NOPULL;
+  g.Speed     = GPIO_SPEED_FREQ_VERY_HIGH;
+  g.Alternate = GPIO_AF10_OTG_FS;
+  HAL_GPIO_Init(GPIOA, &g);
+  __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
+
+  OTG->GAHBCFG &= ~USB_OTG_GAHBCFG_GINT;
+  OTG->GUSBCFG |= USB_OTG_GUSBCFG_PHYSEL;
+  for (uint32_t n = SPIN_MAX; n && !(OTG->GRSTCTL & USB_OTG_GRSTCTL_AHBIDL); n--) { }
+  OTG->GRSTCTL |= USB_OTG_GRSTCTL_CSRST;
+  spin_clear(&OTG->GRSTCTL, USB_OTG_GRSTCTL_CSRST);
+
+  OTG->GCCFG   = USB_OTG_GCCFG_PWRDWN | USB_OTG_GCCFG_NOVBUSSENS;   /* PA9 not wired */
+  OTG->GUSBCFG = (OTG->GUSBCFG & ~(USB_OTG_GUSBCFG_FHMOD | USB_OTG_GUSBCFG_FDMOD | USB_OTG_GUSBCFG_TRDT)) |
+                 USB_OTG_GUSBCFG_FDMOD | (6u << USB_OTG_GUSBCFG_TRDT_Pos);  /* HCLK >= 32 MHz */
+  HAL_Delay(50);                                /* forced device mode takes >= 25 ms */
+
+  PCGCCTL    = 0;
+  DEV->DCTL |= USB_OTG_DCTL_SDIS;               /* stay off the bus until set up */
+  DEV->DCFG |= USB_OTG_DCFG_DSPD;               /* full speed, internal PHY */
+
+  OTG->GRXFSIZ            = RX_FIFO_W;
+  OTG->DIEPTXF0_HNPTXFSIZ = (TX0_FIFO_W << 16) | RX_FIFO_W;
+  OTG->DIEPTXF[0]         = (TX1_FIFO_W << 16) | (RX_FIFO_W + TX0_FIFO_W);
+  OTG->DIEPTXF[1]         = (TX2_FIFO_W << 16) | (RX_FIFO_W + TX0_FIFO_W + TX1_FIFO_W);
+  flush_tx(0x10u);
+  flush_rx();
+
+  DEV->DIEPMSK = 0; DEV->DOEPMSK = 0; DEV->DAINTMSK = 0; DEV->DIEPEMPMSK = 0;
+  for (uint32_t i = 0; i < 4u; i++){
+    INEP(i)->DIEPCTL   = (INEP(i)->DIEPCTL & USB_OTG_DIEPCTL_EPENA) ? (USB_OTG_DIEPCTL_EPDIS | USB_OTG_DIEPCTL_SNAK) : 0u;
+    INEP(i)->DIEPTSIZ  = 0;
+    INEP(i)->DIEPINT   = EP_INT_ALL;
+    OUTEP(i)->DOEPCTL  = (OUTEP(i)->DOEPCTL & USB_OTG_DOEPCTL_EPENA) ? (USB_OTG_DOEPCTL_EPDIS | USB_OTG_DOEPCTL_SNAK) : 0u;
+    OUTEP(i)->DOEPTSIZ = 0;
+    OUTEP(i)->DOEPINT  = EP_INT_ALL;
+  }
+
+  OTG->GINTSTS = 0xBFFFFFFFu;
+  OTG->GINTMSK = USB_OTG_GINTMSK_USBRST | USB_OTG_GINTMSK_ENUMDNEM | USB_OTG_GINTMSK_RXFLVLM |
+                 USB_OTG_GINTMSK_IEPINT | USB_OTG_GINTMSK_OEPINT  | USB_OTG_GINTMSK_USBSUSPM |
+                 USB_OTG_GINTMSK_WUIM;
+  HAL_NVIC_SetPriority(OTG_FS_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
+  OTG->GAHBCFG |= USB_OTG_GAHBCFG_GINT;         /* TX FIFO interrupt at half empty */
+  DEV->DCTL    &= ~USB_OTG_DCTL_SDIS;           /* D+ pull-up: attach */
+}
+
+/* ====== Endpoints ====== */
+void USBFS_EpIn(uint8_t ep, const void *p, uint32_t len){
+  InState *s = &in[ep];
+  uint32_t pk = len ? (len + s->mps - 1u) / s->mps : 1u;
+  s->p   = (const uint8_t *)p;
+  s->rem = len;
+  INEP(ep)->DIEPTSIZ = (pk << USB_OTG_DIEPTSIZ_PKTCNT_Pos) | len;
+  INEP(ep)->DIEPCTL |= USB_OTG_DIEPCTL_CNAK | USB_OTG_DIEPCTL_EPENA;
+  if (len) DEV->DIEPEMPMSK |= 1u << ep;         /* FIFO filled from the TXFE interrupt */
+}
+
+void USBFS_EpOut(uint8_t ep, void *buf, uint32_t len){
+  OutState *s = &out[ep];
+  s->p   = (uint8_t *)buf;
+  s->len = len;
+  s->got = 0;
+  if (ep == 0){ ep0_arm(); return; }
+  uint32_t pk = len ? (len + s->mps - 1u) / s->mps : 1u;
+  OUTEP(ep)->DOEPTSIZ = (pk << USB_OTG_DOEPTSIZ_PKTCNT_Pos) | (pk * s->mps);
+  OUTEP(ep)->DOEPCTL |= USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA;
+}
+
+void USBFS_EpStall(uint8_t ep){
+  INEP(ep)->DIEPCTL  |= USB_OTG_DIEPCTL_STALL;
+  if (ep == 0) OUTEP(0)->DOEPCTL |= USB_OTG_DOEPCTL_STALL;   /* cleared by the next SETUP */
+}
+
+void USBFS_SetAddress(uint8_t addr){
+  DEV->DCFG = (DEV->DCFG & ~USB_OTG_DCFG_DAD) | ((uint32_t)addr << USB_OTG_DCFG_DAD_Pos);
+}
+
+void USBFS_Configure(uint8_t on){
+  const uint32_t bulk = 2u, intr = 3u;
+  const uint32_t mask = (1u << USBFS_EP_BULK) | (1u << USBFS_EP_NOTIFY) | (1u << (16u + USBFS_EP_BULK));
+  if (!on){
+    DEV->DAINTMSK &= ~mask;
+    INEP(USBFS_EP_BULK)->DIEPCTL    &= ~USB_OTG_DIEPCTL_USBAEP;
+    OUTEP(USBFS_EP_BULK)->DOEPCTL   &= ~USB_OTG_DOEPCTL_USBAEP;
+    INEP(USBFS_EP_NOTIFY)->DIEPCTL  &= ~USB_OTG_DIEPCTL_USBAEP;
+    return;
+  }
+  INEP(USBFS_EP_BULK)->DIEPCTL = USB_OTG_DIEPCTL_USBAEP | USB_OTG_DIEPCTL_SD0PID_SEVNFRM |
+                                 (bulk << USB_OTG_DIEPCTL_EPTYP_Pos) |
+                                 ((uint32_t)USBFS_EP_BULK << USB_OTG_DIEPCTL_TXFNUM_Pos) | USBFS_BULK_MPS;
+  OUTEP(USBFS_EP_BULK)->DOEPCTL = USB_OTG_DOEPCTL_USBAEP | USB_OTG_DOEPCTL_SD0PID_SEVNFRM |
+                                  (bulk << USB_OTG_DOEPCTL_EPTYP_Pos) | USBFS_BULK_MPS;
+  INEP(USBFS_EP_NOTIFY)->DIEPCTL = USB_OTG_DIEPCTL_USBAEP | USB_OTG_DIEPCTL_SD0PID_SEVNFRM |
+                                   (intr << USB_OTG_DIEPCTL_EPTYP_Pos) |
+                                   ((uint32_t)USBFS_EP_NOTIFY << USB_OTG_DIEPCTL_TXFNUM_Pos) | USBFS_INT_MPS;
+  DEV->DAINTMSK |= mask;
+}
+
+uint32_t USBFS_UniqueId(uint8_t word){ return ((const uint32_t *)UID_BASE)[word]; }
+
+void USBFS_Lock(void)  { NVIC_DisableIRQ(OTG_FS_IRQn); __DSB(); __ISB(); }
+void USBFS_Unlock(void){ NVIC_EnableIRQ(OTG_FS_IRQn); }
+
+/* ====== Interrupt ====== */
+static void in_fill(uint8_t ep){
+  InState *s = &in[ep];
+  while (s->rem){
+    uint32_t n = (s->rem < s->mps) ? s->rem : s->mps;
+    uint32_t w = (n + 3u) / 4u;
+    if ((INEP(ep)->DTXFSTS & USB_OTG_DTXFSTS_INEPTFSAV) < w) return;   /* wait for next TXFE */
+    for (uint32_t i = 0; i < w; i++, s->p += 4) FIFO(ep) = __UNALIGNED_UINT32_READ(s->p);
+    s->rem -= n;
+  }
+  DEV->DIEPEMPMSK &= ~(1u << ep);
+}
+
+static void rx_pop(void){
+  uint32_t sts = OTG->GRXSTSP;
+  uint8_t  ep  = (uint8_t)(sts & USB_OTG_GRXSTSP_EPNUM);
+  uint32_t n   = (sts & USB_OTG_GRXSTSP_BCNT) >> USB_OTG_GRXSTSP_BCNT_Pos;
+  uint32_t pk  = (sts & USB_OTG_GRXSTSP_PKTSTS) >> USB_OTG_GRXSTSP_PKTSTS_Pos;
+
+  if (pk == PKTSTS_SETUP_DATA){
+    setup_w[0] = FIFO(0);
+    setup_w[1] = FIFO(0);
+  } else if (pk == PKTSTS_OUT_DATA && n && ep < EP_N){
+    OutState *s = &out[ep];
+    for (uint32_t i = 0; i < n; i += 4u){
+      uint32_t w = FIFO(0);
+      for (uint32_t b = 0; b < 4u && i + b < n; b++, w >>= 8)
+        if (s->p && s->got < s->len) s->p[s->got++] = (uint8_t)w;
+    }
+  }
+}
+
+static void out_ints(void){
+  uint32_t pend = (DEV->DAINT & DEV->DAINTMSK) >> 16;
+  for (uint8_t ep = 0; ep < EP_N; ep++){
+    if (!(pend & (1u << ep))) continue;
+    uint32_t i = OUTEP(ep)->DOEPINT;
+    OUTEP(ep)->DOEPINT = i;
+    i &= DEV->DOEPMSK;
+    if (i & USB_OTG_DOEPINT_XFRC){
+      uint32_t got = out[ep].got;
+      if (ep == 0){ out[0].p = NULL; ep0_arm(); }
+      USBFS_OnOutDone(ep, got);
+    }
+    if (i & USB_OTG_DOEPINT_STUP){
+      out[0].p = NULL;
+      ep0_arm();                                 /* status stage / next SETUP */
+      USBFS_OnSetup((const uint8_t *)setup_w);
+    }
+  }
+}
+
+static void in_ints(void){
+  uint32_t pend = DEV->DAINT & DEV->DAINTMSK & 0xFFFFu;
+  for (uint8_t ep = 0; ep < EP_N; ep++){
+    if (!(pend & (1u << ep))) continue;
+    uint32_t msk = DEV->DIEPMSK | (((DEV->DIEPEMPMSK >> ep) & 1u) << 7);   /* TXFE */
+    uint32_t i   = INEP(ep)->DIEPINT & msk;
+    if (i & USB_OTG_DIEPINT_XFRC){
+      INEP(ep)->DIEPINT = USB_OTG_DIEPINT_XFRC;
+      DEV->DIEPEMPMSK  &= ~(1u << ep);
+      USBFS_OnInDone(ep);
+    }
+    if ((i & USB_OTG_DIEPINT_TXFE) && (DEV->DIEPEMPMSK & (1u << ep))) in_fill(ep);
+  }
+}
+
+void USBFS_IRQHandler(void){
+  uint32_t gi = OTG->GINTSTS & OTG->GINTMSK;
+
+  if (gi & USB_OTG_GINTSTS_USBRST){
+    OTG->GINTSTS = USB_OTG_GINTSTS_USBRST;
+    DEV->DCTL &= ~USB_OTG_DCTL_RWUSIG;
+    flush_tx(0x10u);
+    for (uint32_t i = 0; i < 4u; i++){
+      INEP(i)->DIEPINT  = EP_INT_ALL;
+      INEP(i)->DIEPCTL &= ~USB_OTG_DIEPCTL_STALL;
+      OUTEP(i)->DOEPINT  = EP_INT_ALL;
+      OUTEP(i)->DOEPCTL &= ~USB_OTG_DOEPCTL_STALL;
+    }
+    DEV->DAINTMSK   = (1u << 0) | (1u << 16);
+    DEV->DOEPMSK    = USB_OTG_DOEPMSK_STUPM | USB_OTG_DOEPMSK_XFRCM;
+    DEV->DIEPMSK    = USB_OTG_DIEPMSK_XFRCM;
+    DEV->DIEPEMPMSK = 0;
+    DEV->DCFG      &= ~USB_OTG_DCFG_DAD;
+    ep0_arm();
+    USBFS_OnReset();
+  }
+  if (gi & USB_OTG_GINTSTS_ENUMDNE){
+    OTG->GINTSTS = USB_OTG_GINTSTS_ENUMDNE;
+    INEP(0)->DIEPCTL &= ~USB_OTG_DIEPCTL_MPSIZ;  /* 0 = 64 bytes */
+    DEV->DCTL |= USB_OTG_DCTL_CGINAK;
+  }
+  if (gi & USB_OTG_GINTSTS_RXFLVL){
+    OTG->GINTMSK &= ~USB_OTG_GINTMSK_RXFLVLM;
+    while (OTG->GINTSTS & USB_OTG_GINTSTS_RXFLVL) rx_pop();
+    OTG->GINTMSK |= USB_OTG_GINTMSK_RXFLVLM;
+  }
+  if (gi & USB_OTG_GINTSTS_OEPINT) out_ints();
+  if (gi & USB_OTG_GINTSTS_IEPINT) in_ints();
+  if (gi & USB_OTG_GINTSTS_USBSUSP){
+    OTG->GINTSTS = USB_OTG_GINTSTS_USBSUSP;
+    USBFS_OnSuspend(1);
+  }
+  if (gi & USB_OTG_GINTSTS_WKUINT){
+    OTG->GINTSTS = USB_OTG_GINTSTS_WKUINT;
+    USBFS_OnSuspend(0);
+  }
+}
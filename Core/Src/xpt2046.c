@@ -1,4 +1,7 @@
 #include "xpt2046.h"
+#include "touch_trace.h"
+#include "deferred.h"
+#include "xpt_map.h"
 
 /* ====== Internal: SPI handle & pins ====== */
 static SPI_HandleTypeDef *tp_spi = NULL;
@@ -7,115 +10,284 @@ static inline void TCS_LOW(void){  HAL_GPIO_WritePin(XPT_CS_GPIO, XPT_CS_PIN, GP
 static inline void TCS_HIGH(void){ HAL_GPIO_WritePin(XPT_CS_GPIO, XPT_CS_PIN, GPIO_PIN_SET);   }
 static inline uint8_t PENIRQ(void){return (uint8_t)HAL_GPIO_ReadPin(XPT_IRQ_GPIO, XPT_IRQ_PIN);} /* LOW when pressed */
 
+static void burst_build(void);
+
 /* ====== XPT2046 command bytes (12-bit differential) ====== */
 #define CMD_X   0xD0  /* 1101 0000 : X position */
 #define CMD_Y   0x90  /* 1001 0000 : Y position */
+#define CMD_Z1  0xB0  /* 1011 0000 : Z1 pressure */
+#define CMD_Z2  0xC0  /* 1100 0000 : Z2 pressure */
 
-/* ====== Calibration & rotation ====== */
-static int32_t cal_x_min = 350, cal_x_max = 3800;
-static int32_t cal_y_min = 350, cal_y_max = 3800;
+/* ====== Auxiliary inputs (12-bit single-ended, internal 2.5 V ref on) ====== */
+#define CMD_TEMP0  0x86  /* 1000 0110 : die temp, diode @ 1x current  */
+#define CMD_VBAT   0xA6  /* 1010 0110 : VBAT (internal /4 divider)    */
+#define CMD_AUX    0xE6  /* 1110 0110 : AUXIN                         */
+#define CMD_TEMP1  0xF6  /* 1111 0110 : die temp, diode @ 91x current */
+#define CMD_PWRDN  0x80  /* 1000 0000 : dummy conversion, ref off, PENIRQ on */
 
-/* Output (displayed) size and rotation */
-static uint16_t out_w = 320, out_h = 240;  /* MUST match UI after rotation */
-static uint16_t rot   = 90;                /* 0/90/180/270 */
+/* ====== Calibration & rotation ====== */
+/* Output (displayed) size MUST match UI after rotation */
+static XPT_Map map = { 350, 3800, 350, 3800, 320, 240, 90 };
 
 void XPT_SetCalibration(int32_t x_min, int32_t x_max,
                         int32_t y_min, int32_t y_max){
-    cal_x_min = x_min; cal_x_max = x_max;
-    cal_y_min = y_min; cal_y_max = y_max;
+    map.x_min = x_min; map.x_max = x_max;
+    map.y_min = y_min; map.y_max = y_max;
+}
+
+void XPT_GetCalibration(int32_t *x_min, int32_t *x_max,
+                        int32_t *y_min, int32_t *y_max){
+    if(x_min) *x_min = map.x_min;
+    if(x_max) *x_max = map.x_max;
+    if(y_min) *y_min = map.y_min;
+    if(y_max) *y_max = map.y_max;
 }
 
 void XPT_Init(SPI_HandleTypeDef *hspi, uint8_t rot_deg,
               uint16_t screen_w, uint16_t screen_h){
     tp_spi = hspi;
-    rot    = rot_deg;
-    out_w  = screen_w;   /* displayed (rotated) width */
-    out_h  = screen_h;   /* displayed (rotated) height */
+    map.rot = rot_deg;
+    map.w   = screen_w;  /* displayed (rotated) width */
+    map.h   = screen_h;  /* displayed (rotated) height */
 
     /* Ensure CS high when idle */
     TCS_HIGH();
+    burst_build();
     /* Pins config in CubeMX:
        - XPT_CS as Output PP, no pull
        - XPT_IRQ as Input with Pull-Up
        - SPI mode 0 (CPOL=0, CPHA=0) shared with TFT */
 }
 
-/* ====== Low-level: read 12-bit value for a given command ====== */
-static uint16_t read12(uint8_t cmd){
-    uint8_t tx[3] = {cmd, 0x00, 0x00};
-    uint8_t rx[3] = {0};
+/* ====== Aux scheduler state (conversions ride in the DMA burst) ====== */
+static uint16_t aux_period[XPT_AUX_COUNT];   /* ms, 0 = disabled */
+static uint32_t aux_t_last[XPT_AUX_COUNT];
+static uint16_t aux_raw[XPT_AUX_COUNT];      /* TEMP: TEMP1-TEMP0 delta */
+static uint8_t  aux_valid = 0;               /* bit per channel */
+static uint8_t  aux_next  = 0;               /* round-robin cursor */
+static uint8_t  aux_ch    = XPT_AUX_COUNT;   /* channel in the current burst */
+static uint32_t aux_t_pick;
+
+/* ====== DMA burst: whole touch read in one CS window ======
+ * Layout (3 bytes per conversion: cmd, hi, lo):
+ *   dummy Y, dummy X, Z1, Z2, XPT_BURST_N x (Y, X) [, aux tail]
+ * The touch part of TX is built once. A due aux channel writes its 3-4
+ * conversions into the tail for that burst only; with the pen up the tail
+ * is sent on its own. The DMA-complete ISR only releases CS and the RX is
+ * decoded in burst_decode() as a PendSV bottom half (deferred.c). */
+#define BURST_CONV   (4U + 2U * XPT_BURST_N)
+#define BURST_LEN    (3U * BURST_CONV)
+#define AUX_CONV_MAX 4U                       /* settle, value, TEMP1, power-down */
+
+static uint8_t burst_tx[BURST_LEN + 3U * AUX_CONV_MAX];
+static uint8_t burst_rx[BURST_LEN + 3U * AUX_CONV_MAX];
+static volatile uint8_t burst_busy = 0;
+static volatile uint8_t burst_done = 0;
+static uint8_t burst_touch = 0;               /* touch part in the current burst */
+static XPT_Burst burst_res;
+
+static void burst_build(void){
+    static const uint8_t head[4] = { CMD_Y, CMD_X, CMD_Z1, CMD_Z2 };
+    uint32_t k = 0;
+    for(uint32_t i = 0; i < sizeof(burst_tx); i++) burst_tx[i] = 0x00;
+    for(uint32_t i = 0; i < 4; i++)           { burst_tx[3U * k++] = head[i]; }
+    for(uint32_t i = 0; i < XPT_BURST_N; i++) { burst_tx[3U * k++] = CMD_Y;
+                                                burst_tx[3U * k++] = CMD_X; }
+}
+
+static inline uint16_t burst_val(uint32_t conv){
+    const uint8_t *r = &burst_rx[3U * conv];
+    return (uint16_t)((r[1] << 5) | (r[2] >> 3));
+}
 
-    /* discard-first trick: toggle CS and make an extra dummy read improves stability */
+/* Next due channel, round robin, at most one per burst: writes its command
+ * bytes into the burst tail and returns the number of conversions (0 = none). */
+static uint32_t aux_pick(void){
+    uint32_t now = HAL_GetTick();
+    aux_ch = XPT_AUX_COUNT;
+    for(uint8_t k = 0; k < XPT_AUX_COUNT; k++){
+        uint8_t ch = (uint8_t)((aux_next + k) % XPT_AUX_COUNT);
+        uint32_t per = aux_period[ch];
+        if(!per || (now - aux_t_last[ch]) < per) continue;
+
+        uint8_t cmd = (ch == XPT_AUX_VBAT) ? CMD_VBAT : (ch == XPT_AUX_AUXIN) ? CMD_AUX : CMD_TEMP0;
+        uint8_t *t = &burst_tx[BURST_LEN];
+        uint32_t n = 0;
+        t[3U * n++] = cmd;                    /* powers the reference up, settles S/H */
+        t[3U * n++] = cmd;
+        if(ch == XPT_AUX_TEMP) t[3U * n++] = CMD_TEMP1;
+        t[3U * n++] = CMD_PWRDN;              /* ref off again, PENIRQ re-armed */
+
+        aux_ch     = ch;
+        aux_t_pick = now;
+        aux_next   = (uint8_t)((ch + 1) % XPT_AUX_COUNT);
+        return n;
+    }
+    return 0;
+}
+
+static void aux_decode(void){
+    uint16_t v = burst_val(BURST_CONV + 1U);
+    if(aux_ch == XPT_AUX_TEMP){
+        uint16_t t1 = burst_val(BURST_CONV + 2U);
+        v = (t1 > v) ? (uint16_t)(t1 - v) : 0;
+    }
+    aux_raw[aux_ch]    = v;
+    aux_valid         |= (uint8_t)(1U << aux_ch);
+    aux_t_last[aux_ch] = aux_t_pick;          /* a dropped burst retries next poll */
+}
+
+/* Touch part when the pen is down, plus the aux tail when a channel is due */
+static uint8_t burst_start(uint8_t pen_down){
+    if(!tp_spi || burst_busy) return 0;
+    if(HAL_SPI_GetState(tp_spi) != HAL_SPI_STATE_READY) return 0;
+
+    uint32_t off = pen_down ? 0U : BURST_LEN;
+    uint32_t len = (BURST_LEN - off) + 3U * aux_pick();
+    if(!len) return 0;
+
+    burst_touch = pen_down;
+    burst_done  = 0;
+    burst_busy  = 1;
     TCS_LOW();
-    HAL_SPI_Transmit(tp_spi, &tx[0], 1, HAL_MAX_DELAY);
-    HAL_SPI_TransmitReceive(tp_spi, &tx[1], &rx[1], 2, HAL_MAX_DELAY);
+    if(HAL_SPI_TransmitReceive_DMA(tp_spi, &burst_tx[off], &burst_rx[off], (uint16_t)len) != HAL_OK){
+        TCS_HIGH();
+        burst_busy = 0;
+        return 0;
+    }
+    return 1;
+}
+
+uint8_t XPT_BurstStart(void){
+    if(PENIRQ() == GPIO_PIN_SET) return 0;   /* pen up: nothing to sample */
+    return burst_start(1);
+}
+
+uint8_t XPT_BurstBusy(void){ return burst_busy; }
+
+uint8_t XPT_BurstTake(XPT_Burst *out){
+    if(!burst_done) return 0;
+    burst_done = 0;
+    if(out) *out = burst_res;
+    return 1;
+}
+
+/* Bottom half: burst_busy stays set until the result is published, so
+ * no new burst can overwrite burst_rx while it is being decoded. */
+static void burst_decode(void *arg){
+    (void)arg;
+    if(aux_ch < XPT_AUX_COUNT) aux_decode();
+    if(burst_touch){
+        burst_res.z1 = burst_val(2);
+        burst_res.z2 = burst_val(3);
+        for(uint32_t i = 0; i < XPT_BURST_N; i++){
+            uint16_t ry = burst_val(4U + 2U * i);
+            uint16_t rx = burst_val(5U + 2U * i);
+            burst_res.xs[i] = rx; burst_res.ys[i] = ry;
+        }
+        burst_res.x = XPT_MapFilter(burst_res.xs, XPT_BURST_N);
+        burst_res.y = XPT_MapFilter(burst_res.ys, XPT_BURST_N);
+    }
+
+    burst_busy = 0;
+    burst_done = burst_touch;                 /* aux-only bursts publish no touch result */
+}
+
+/* SPI1 is shared with the TFT (blocking calls only), so any DMA TxRx
+ * completion on tp_spi while a burst is in flight is ours. */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi){
+    if(hspi != tp_spi || !burst_busy) return;
     TCS_HIGH();
+    if(!Defer_Post(burst_decode, NULL)) burst_decode(NULL);  /* queue full: decode here */
+}
 
-    /* 12-bit packed: [rx1:8][rx2: high 4 bits][low 4 bits don't care] */
-    return (uint16_t)((rx[1] << 5) | (rx[2] >> 3));
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi){
+    if(hspi != tp_spi || !burst_busy) return;
+    TCS_HIGH();
+    burst_busy = 0;                         /* result dropped, next poll retries */
 }
 
 /* ====== Public: read raw averaged X/Y (no mapping) ====== */
+static uint8_t tt_was_down = 0; /* trace: log pen-up once per release */
+
+/* With the pen up this still runs a due aux conversion (tail-only burst). */
 uint8_t XPT_ReadRaw(uint16_t *raw_x, uint16_t *raw_y){
-    if(PENIRQ() == GPIO_PIN_SET) return 0; /* not pressed (IRQ is low when pressed) */
+    uint8_t down = (PENIRQ() == GPIO_PIN_RESET);  /* IRQ is low when pressed */
+    if(!down && tt_was_down){ TouchTrace_Record(0, 0, 0, 0, 0, 0); tt_was_down = 0; }
+
+    if(!burst_start(down)) return 0;
+
+    /* Sleep until the DMA completes. PRIMASK keeps the check-then-WFI
+     * race-free: a pending IRQ still wakes the core and runs once re-enabled. */
+    uint32_t t0 = HAL_GetTick();
+    __disable_irq();
+    while(burst_busy && (HAL_GetTick() - t0) < 2U){
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
 
-    const uint8_t N = 6; /* small average for noise reduction */
-    uint32_t sx = 0, sy = 0;
+    if(burst_busy){                          /* stuck transfer: abort, release CS */
+        HAL_SPI_Abort(tp_spi);
+        TCS_HIGH();
+        burst_busy = 0;
+        return 0;
+    }
 
-    /* First dummy cycle (recommended) */
-    (void)read12(CMD_Y);
-    (void)read12(CMD_X);
+    XPT_Burst b;
+    if(!XPT_BurstTake(&b)) return 0;         /* pen up: aux only, no point */
 
-    for(uint8_t i=0;i<N;i++){
-        uint16_t ry = read12(CMD_Y);
-        uint16_t rx = read12(CMD_X);
-        sx += rx; sy += ry;
+    if(TouchTrace_Active()){
+        for(uint8_t i = 0; i < XPT_BURST_N; i++){
+            TouchTrace_Record((uint8_t)(TT_PEN_DOWN | (i == 0 ? TT_BURST_START : 0)),
+                              i, b.xs[i], b.ys[i], b.z1, b.z2);
+        }
     }
+    tt_was_down = 1;
 
-    if(raw_x) *raw_x = (uint16_t)(sx / N);
-    if(raw_y) *raw_y = (uint16_t)(sy / N);
+    if(raw_x) *raw_x = b.x;
+    if(raw_y) *raw_y = b.y;
     return 1;
 }
 
-/* ====== Map raw -> screen directly in displayed space ====== */
-static uint8_t map_to_screen(uint16_t rx, uint16_t ry, uint16_t *sx, uint16_t *sy){
-    if(cal_x_max <= cal_x_min || cal_y_max <= cal_y_min) return 0;
-
-    /* normalize 0..1 */
-    float nx = (float)((int32_t)rx - cal_x_min) / (float)(cal_x_max - cal_x_min);
-    float ny = (float)((int32_t)ry - cal_y_min) / (float)(cal_y_max - cal_y_min);
-    if (nx < 0.f) { nx = 0.f; }
-    if (nx > 1.f) { nx = 1.f; }
-
-    if (ny < 0.f) { ny = 0.f; }
-    if (ny > 1.f) { ny = 1.f; }
-
-    /* apply rotation – ROT_90: sx=y; sy=x (no inversion) */
-    switch(rot){
-        case 0:
-            *sx = (uint16_t)(nx * (out_w  - 1));
-            *sy = (uint16_t)(ny * (out_h  - 1));
-            break;
-        case 90:
-            *sx = (uint16_t)(ny * (out_w  - 1));
-            *sy = (uint16_t)(nx * (out_h  - 1));
-            break;
-        case 180:
-            *sx = (uint16_t)((1.f - nx) * (out_w  - 1));
-            *sy = (uint16_t)((1.f - ny) * (out_h  - 1));
-            break;
-        case 270:
-            *sx = (uint16_t)((1.f - ny) * (out_w  - 1));
-            *sy = (uint16_t)((1.f - nx) * (out_h  - 1));
-            break;
-        default:
-            *sx = (uint16_t)(nx * (out_w  - 1));
-            *sy = (uint16_t)(ny * (out_h  - 1));
-            break;
-    }
+/* ====== Aux channels ====== */
+void XPT_AuxEnable(XPT_AuxChannel ch, uint16_t period_ms){
+    if(ch >= XPT_AUX_COUNT) return;
+    aux_period[ch] = period_ms;
+    aux_t_last[ch] = HAL_GetTick() - period_ms;  /* due on next poll */
+}
+
+uint8_t XPT_AuxGetRaw(XPT_AuxChannel ch, uint16_t *raw){
+    if(ch >= XPT_AUX_COUNT || !(aux_valid & (1U << ch))) return 0;
+    if(raw) *raw = aux_raw[ch];
     return 1;
 }
 
+uint8_t XPT_AuxGetMillivolts(XPT_AuxChannel ch, uint32_t *mv){
+    uint16_t r;
+    if(ch == XPT_AUX_TEMP || !XPT_AuxGetRaw(ch, &r)) return 0;
+    uint32_t v = ((uint32_t)r * XPT_AUX_VREF_MV) / 4096U;
+    if(ch == XPT_AUX_VBAT) v *= 4U;           /* VBAT pin is divided by 4 on-chip */
+    if(mv) *mv = v;
+    return 1;
+}
+
+/* Datasheet 2-point method: T(K) = 2.573 K/mV * (V_TEMP1 - V_TEMP0) */
+uint8_t XPT_AuxGetTempC10(int16_t *t_c10){
+    uint16_t d;
+    if(!XPT_AuxGetRaw(XPT_AUX_TEMP, &d)) return 0;
+    /* 0.1 K = d * VREF/4096 mV * 25.73 -> d * 64325 / 4096 for a 2.5 V ref */
+    int32_t k10 = (int32_t)(((uint32_t)d * (XPT_AUX_VREF_MV * 2573U / 100U)) / 4096U);
+    if(t_c10) *t_c10 = (int16_t)(k10 - 2732);
+    return 1;
+}
+
+/* ====== Map raw -> screen (xpt_map.c, shared with the host replay) ====== */
+uint8_t XPT_MapRaw(uint16_t rx, uint16_t ry, uint16_t *sx, uint16_t *sy){
+    return XPT_MapApply(&map, rx, ry, sx, sy);
+}
+
 /* ====== Public: mapped point ====== */
 uint8_t XPT_GetPoint(XPT_TouchPoint *tp){
     if(!tp) return 0;
@@ -125,7 +297,7 @@ uint8_t XPT_GetPoint(XPT_TouchPoint *tp){
     if(!XPT_ReadRaw(&rx,&ry)) return 0;
 
     uint16_t sx=0, sy=0;
-    if(!map_to_screen(rx, ry, &sx, &sy)) return 0;
+    if(!XPT_MapRaw(rx, ry, &sx, &sy)) return 0;
 
     tp->x = sx;
     tp->y = sy;
@@ -142,7 +314,7 @@ uint8_t XPT_GetPointWithRaw(XPT_TouchPoint *tp, uint16_t *raw_x, uint16_t *raw_y
     if(!XPT_ReadRaw(&rx,&ry)) return 0;
 
     uint16_t sx=0, sy=0;
-    if(!map_to_screen(rx, ry, &sx, &sy)) return 0;
+    if(!XPT_MapRaw(rx, ry, &sx, &sy)) return 0;
 
     if(raw_x) *raw_x = rx;
     if(raw_y) *raw_y = ry;
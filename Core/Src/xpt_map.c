@@ -0,0 +1,45 @@
+#include "xpt_map.h"
+
+/* ====== Burst filter: plain mean ====== */
+uint16_t XPT_MapFilter(const uint16_t *v, uint8_t n){
+    uint32_t s = 0;
+    if(n == 0) return 0;
+    for(uint8_t i = 0; i < n; i++) s += v[i];
+    return (uint16_t)(s / n);
+}
+
+/* ====== Map raw -> screen directly in displayed space ====== */
+uint8_t XPT_MapApply(const XPT_Map *m, uint16_t rx, uint16_t ry,
+                     uint16_t *sx, uint16_t *sy){
+    if(m->x_max <= m->x_min || m->y_max <= m->y_min) return 0;
+
+    /* normalize 0..1 */
+    float nx = (float)((int32_t)rx - m->x_min) / (float)(m->x_max - m->x_min);
+    float ny = (float)((int32_t)ry - m->y_min) / (float)(m->y_max - m->y_min);
+    if (nx < 0.f) { nx = 0.f; }
+    if (nx > 1.f) { nx = 1.f; }
+
+    if (ny < 0.f) { ny = 0.f; }
+    if (ny > 1.f) { ny = 1.f; }
+
+    /* apply rotation – ROT_90: sx=y; sy=x (no inversion) */
+    switch(m->rot){
+        case 90:
+            *sx = (uint16_t)(ny * (m->w - 1));
+            *sy = (uint16_t)(nx * (m->h - 1));
+            break;
+        case 180:
+            *sx = (uint16_t)((1.f - nx) * (m->w - 1));
+            *sy = (uint16_t)((1.f - ny) * (m->h - 1));
+            break;
+        case 270:
+            *sx = (uint16_t)((1.f - ny) * (m->w - 1));
+            *sy = (uint16_t)((1.f - nx) * (m->h - 1));
+            break;
+        default:                                  /* 0 */
+            *sx = (uint16_t)(nx * (m->w - 1));
+            *sy = (uint16_t)(ny * (m->h - 1));
+            break;
+    }
+    return 1;
+}
@@ -0,0 +1,145 @@
+/* Host session against the CDC-ACM class (usb_cdc.c) over the simulated
+ * endpoint layer (usbfs_sim.c).
+ *
+ *   - enumeration: descriptors (short and long wLength), serial string
+ *     from the unique ID, address, configuration, unknown request stall
+ *   - line coding round trip; nothing is accepted until DTR
+ *   - console ring: data order, wrap-around, overflow counted as dropped
+ *   - segments: sent by reference in order, split at USBFS_XFER_MAX, a
+ *     ZLP after a transfer that ends on a packet boundary, `done` once
+ *     each, queue-full rejection
+ *   - bulk OUT to the receive handler, bus reset flushes the queue
+ *   - USBCDC_GetStats() agrees with what the host saw */
+
+#include "usb_cdc.h"
+#include "usbfs_sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int fail;
+
+#define CHECK(c) do { if(!(c)){ printf("FAIL line %d: %s\n", __LINE__, #c); fail = 1; } } while(0)
+
+static SimCapture cap;
+static uint32_t   done_n[16];
+static uint8_t    rx_got[64];
+static uint32_t   rx_n;
+
+static void on_done(void *ctx){ done_n[(uintptr_t)ctx]++; }
+static void on_rx(const uint8_t *p, uint32_t len){ memcpy(rx_got + rx_n, p, len); rx_n += len; }
+
+static void cap_clear(void){ memset(&cap, 0, sizeof(cap)); }
+
+static void enumerate(void){
+    uint8_t d[256];
+
+    SimUSB_Reset();
+    CHECK(SimUSB_Control(0x80, 0x06, 0x0100, 0, 64, NULL, d) == 18);
+    CHECK(d[0] == 18 && d[1] == 0x01 && d[8] == 0x83 && d[9] == 0x04);   /* VID 0483 */
+    CHECK(SimUSB_Control(0x00, 0x05, 7, 0, 0, NULL, NULL) == 0);
+    CHECK(SimUSB_Address() == 7);
+    CHECK(SimUSB_Control(0x80, 0x06, 0x0200, 0, 9, NULL, d) == 9);
+    uint16_t total = (uint16_t)(d[2] | d[3] << 8);
+    CHECK(SimUSB_Control(0x80, 0x06, 0x0200, 0, 255, NULL, d) == total);
+    CHECK(SimUSB_Control(0x80, 0x06, 0x0303, 0x0409, 255, NULL, d) == 2 + 2 * 24);
+    CHECK(d[2] == '0' && d[14] == '2' && d[18] == '1');   /* "00300020" "11411131" ... from the sim */
+    CHECK(SimUSB_Control(0x80, 0x06, 0x0600, 0, 10, NULL, d) == -1);     /* no qualifier */
+    CHECK(SimUSB_Control(0x00, 0x09, 1, 0, 0, NULL, NULL) == 0);
+    CHECK(SimUSB_Configured());
+}
+
+int main(void){
+    uint8_t d[64];
+    static uint8_t big[40000];
+    static uint8_t seg[3][128];
+
+    USBCDC_Init();
+    USBCDC_SetRxHandler(on_rx);
+    enumerate();
+
+    /* Line coding; closed port refuses data */
+    static const uint8_t lc[7] = { 0x80, 0x25, 0, 0, 0, 0, 8 };           /* 9600 8N1 */
+    CHECK(SimUSB_Control(0x21, 0x20, 0, 0, 7, lc, NULL) == 0);
+    CHECK(SimUSB_Control(0xA1, 0x21, 0, 0, 7, NULL, d) == 7 && memcmp(d, lc, 7) == 0);
+    CHECK(!USBCDC_Ready());
+    CHECK(USBCDC_Write("x", 1) == 0);
+    CHECK(!USBCDC_Submit(big, 10, on_done, (void *)0));
+    CHECK(SimUSB_Control(0x21, 0x22, 1, 0, 0, NULL, NULL) == 0);          /* DTR */
+    CHECK(USBCDC_Ready());
+
+    /* Console ring */
+    cap_clear();
+    CHECK(USBCDC_Write("hello\r\n", 7) == 7);
+    CHECK(!SimUSB_InArmed(USBFS_EP_BULK));              /* waits for Poll */
+    USBCDC_Poll();
+    CHECK(SimUSB_Drain(&cap) == 7 && memcmp(cap.data, "hello\r\n", 7) == 0);
+
+    cap_clear();                                        /* wraps: two transfers */
+    for(uint32_t i = 0; i < 2000u; i++) big[i] = (uint8_t)i;
+    CHECK(USBCDC_Write(big, 2000) == 2000);
+    USBCDC_Poll();
+    SimUSB_Drain(&cap);
+    CHECK(USBCDC_Write("abcdefghijklmnopqrstuvwxyz0123456789", 36) == 36);
+    CHECK(USBCDC_Write("ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26) == 26);
+    USBCDC_Poll();
+    SimUSB_Drain(&cap);
+    CHECK(cap.n == 2062 && cap.xfers >= 3);
+    CHECK(memcmp(cap.data + 2000, "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ", 62) == 0);
+    for(uint32_t i = 0; i < 2000u; i++) if(cap.data[i] != (uint8_t)i){ CHECK(0); break; }
+
+    USBCDC_Stats st0;
+    USBCDC_GetStats(&st0);
+    CHECK(st0.baud == 9600u && st0.dropped == 0);
+    CHECK(USBCDC_Write(big, 3000) == USBCDC_RING_SIZE); /* full ring: rest dropped */
+    USBCDC_Stats st1;
+    USBCDC_GetStats(&st1);
+    CHECK(st1.dropped == 3000u - USBCDC_RING_SIZE);
+    USBCDC_Poll();
+    cap_clear();
+    SimUSB_Drain(&cap);
+    CHECK(cap.n == USBCDC_RING_SIZE);
+
+    /* Segments by reference */
+    cap_clear();
+    for(uint32_t i = 0; i < sizeof(big); i++) big[i] = (uint8_t)(i * 7u);
+    memset(seg, 0x5A, sizeof(seg));
+    CHECK(USBCDC_Submit(big, sizeof(big), on_done, (void *)1));
+    CHECK(USBCDC_Submit(seg[0], 128, on_done, (void *)2));
+    memset(big, 0, 16);                                 /* still owned by the queue */
+    SimUSB_Drain(&cap);
+    CHECK(cap.n == sizeof(big) + 128);
+    CHECK(cap.xfer_len[0] == USBFS_XFER_MAX && cap.xfer_len[1] == sizeof(big) - USBFS_XFER_MAX);
+    CHECK(cap.xfer_len[2] == 128 && cap.xfer_len[3] == 0 && cap.xfers == 4);   /* ZLP */
+    CHECK(cap.data[0] == 0 && cap.data[16] == (uint8_t)(16 * 7));
+    CHECK(done_n[1] == 1 && done_n[2] == 1);
+
+    for(uint32_t i = 0; i < USBCDC_TXQ_DEPTH; i++)        /* in flight counts as queued */
+        CHECK(USBCDC_Submit(seg[1], 10, on_done, (void *)3));
+    CHECK(!USBCDC_Submit(seg[1], 10, on_done, (void *)4));
+    CHECK(done_n[4] == 0);
+    cap_clear();
+    SimUSB_Drain(&cap);
+    CHECK(cap.n == 10u * USBCDC_TXQ_DEPTH && done_n[3] == USBCDC_TXQ_DEPTH);
+
+    /* Bulk OUT */
+    CHECK(SimUSB_Write("ping", 4));
+    CHECK(rx_n == 4 && memcmp(rx_got, "ping", 4) == 0);
+
+    /* Bus reset mid-transfer: queued segments come back through done */
+    CHECK(USBCDC_Submit(seg[2], 100, on_done, (void *)5));
+    CHECK(USBCDC_Submit(seg[2], 100, on_done, (void *)5));
+    SimUSB_Reset();
+    CHECK(done_n[5] == 2 && !USBCDC_Ready());
+    enumerate();
+    CHECK(!USBCDC_Ready());                             /* DTR again after reconfiguration */
+
+    USBCDC_Stats st;
+    USBCDC_GetStats(&st);
+    CHECK(st.rx_bytes == 4);
+    CHECK(st.dropped == (3000u - USBCDC_RING_SIZE) + 10u);
+    CHECK(SimUSB_Errors() == 0);
+
+    printf(fail ? "cdc_session FAILED\n" : "cdc_session ok\n");
+    return fail;
+}
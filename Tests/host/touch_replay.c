@@ -0,0 +1,262 @@
+/* Host replay of touch traces (TouchTrace_Dump output) through the target's
+ * burst filter + mapping (xpt_map.c) and press/release state machine
+ * (touch_sm.c).
+ *
+ *   touch_replay                 built-in synthetic traces, checks the metrics
+ *   touch_replay trace.csv ...   replay captured dumps and print the report
+ *
+ * A dump's closing "# crc32=" line is checked with the software reference
+ * (integrity_ref.c) before the report; a damaged capture is skipped.
+ *
+ * Report per trace:
+ *   latency  DOWN: first conversion of the stroke -> DOWN event
+ *            UP:   last pen-down conversion       -> UP event
+ *   jitter   burst interval spread while down, position spread inside taps
+ *   misclassified taps (press <= TAP_MAX_MS):
+ *            split  stroke starts < BOUNCE_MS after the previous release,
+ *                   within TAP_SLOP_PX of it (one tap seen as two)
+ *            moved  release point > TAP_SLOP_PX from the press point
+ *                   (the UI acts on a different spot than was pressed) */
+
+#include "touch_sm.h"
+#include "touch_trace.h"
+#include "xpt_map.h"
+#include "integrity_ref.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BURST_N       6         /* XPT_BURST_N */
+#define SCREEN_W      320       /* as passed to XPT_Init() in main.c */
+#define SCREEN_H      240
+#define SCREEN_ROT    90
+#define TAP_MAX_MS    300u
+#define TAP_SLOP_PX   12
+#define BOUNCE_MS     50u
+#define MAX_SAMPLES   65536
+
+typedef struct {
+    uint32_t n;
+    double   sum, sum2, max;
+} Acc;
+
+static void acc_add(Acc *a, double v){
+    a->n++; a->sum += v; a->sum2 += v * v;
+    if(v > a->max) a->max = v;
+}
+static double acc_mean(const Acc *a){ return a->n ? a->sum / a->n : 0.0; }
+static double acc_sd(const Acc *a){
+    if(a->n < 2) return 0.0;
+    double m = acc_mean(a), v = a->sum2 / a->n - m * m;
+    return v > 0.0 ? sqrt(v) : 0.0;
+}
+
+typedef struct {
+    uint32_t strokes, taps, split, moved;
+    Acc      lat_down_us, lat_up_us, interval_us, tap_pos_px;
+} Report;
+
+/* ====== Replay ====== */
+static void replay(const TouchTraceSample *s, uint32_t n, const XPT_Map *map, Report *r){
+    TouchSM  sm;
+    uint32_t t_stroke0 = 0, t_last_down = 0, t_prev_burst = 0, t_prev_up = 0;
+    uint16_t up_x = 0, up_y = 0;
+    uint8_t  have_up = 0, have_prev_burst = 0;
+    double   px_sum = 0, py_sum = 0, p2_sum = 0;
+    uint32_t p_n = 0;
+
+    TouchSM_Reset(&sm);
+    memset(r, 0, sizeof(*r));
+
+    for(uint32_t i = 0; i < n; ){
+        if(s[i].flags & TT_PEN_DOWN){
+            /* one poll = one burst: TT_BURST_START + following conversions */
+            uint16_t xs[BURST_N], ys[BURST_N];
+            uint8_t  k = 0;
+            uint32_t t_first = s[i].t_us;
+            do {
+                if(k < BURST_N){ xs[k] = s[i].x; ys[k] = s[i].y; k++; }
+                t_last_down = s[i].t_us;
+                i++;
+            } while(i < n && (s[i].flags & TT_PEN_DOWN) && !(s[i].flags & TT_BURST_START));
+
+            uint16_t sx, sy;
+            if(!XPT_MapApply(map, XPT_MapFilter(xs, k), XPT_MapFilter(ys, k), &sx, &sy)) continue;
+
+            if(have_prev_burst) acc_add(&r->interval_us, (double)(t_last_down - t_prev_burst));
+            t_prev_burst    = t_last_down;
+            have_prev_burst = 1;
+
+            TouchEvent ev = TouchSM_Update(&sm, 1, sx, sy, t_last_down / 1000u);
+            if(ev == TOUCH_EV_DOWN){
+                t_stroke0 = t_first;
+                acc_add(&r->lat_down_us, (double)(t_last_down - t_stroke0));
+                px_sum = py_sum = p2_sum = 0; p_n = 0;
+                r->strokes++;
+                if(have_up && (t_first - t_prev_up) < BOUNCE_MS * 1000u &&
+                   abs((int)sx - up_x) <= TAP_SLOP_PX && abs((int)sy - up_y) <= TAP_SLOP_PX)
+                    r->split++;
+            }
+            px_sum += sx; py_sum += sy; p2_sum += (double)sx * sx + (double)sy * sy; p_n++;
+        } else {
+            uint32_t t = s[i].t_us;
+            i++;
+            if(TouchSM_Update(&sm, 0, 0, 0, t / 1000u) != TOUCH_EV_UP) continue;
+            acc_add(&r->lat_up_us, (double)(t - t_last_down));
+            have_prev_burst = 0;
+            if((t_last_down - t_stroke0) / 1000u <= TAP_MAX_MS){
+                r->taps++;
+                if(abs((int)sm.x - sm.x0) > TAP_SLOP_PX || abs((int)sm.y - sm.y0) > TAP_SLOP_PX)
+                    r->moved++;
+                double mx = px_sum / p_n, my = py_sum / p_n;
+                double v  = p2_sum / p_n - mx * mx - my * my;
+                acc_add(&r->tap_pos_px, v > 0.0 ? sqrt(v) : 0.0);
+            }
+            up_x = sm.x; up_y = sm.y; t_prev_up = t; have_up = 1;
+        }
+    }
+}
+
+static void print_report(const char *name, const Report *r){
+    printf("%s\n", name);
+    printf("  strokes %u, taps %u, misclassified %u (split %u, moved %u)\n",
+           r->strokes, r->taps, r->split + r->moved, r->split, r->moved);
+    printf("  latency down  mean %7.0f us  max %7.0f us\n", acc_mean(&r->lat_down_us), r->lat_down_us.max);
+    printf("  latency up    mean %7.0f us  max %7.0f us\n", acc_mean(&r->lat_up_us), r->lat_up_us.max);
+    printf("  poll interval mean %7.0f us  sd  %7.0f us\n", acc_mean(&r->interval_us), acc_sd(&r->interval_us));
+    printf("  tap position spread mean %.2f px  max %.2f px\n", acc_mean(&r->tap_pos_px), r->tap_pos_px.max);
+}
+
+/* ====== Dump parser ====== */
+enum { CRC_NONE, CRC_BAD, CRC_OK };
+
+/* Every byte between the '#' lines, for the crc32 check. */
+static char  *txt;
+static size_t txt_n, txt_cap;
+
+static void txt_add(const char *line){
+    size_t k = strlen(line);
+    if(txt_n + k > txt_cap){
+        txt_cap = (txt_n + k) * 2u;
+        txt     = realloc(txt, txt_cap);
+        if(!txt){ perror("realloc"); exit(1); }
+    }
+    memcpy(txt + txt_n, line, k);
+    txt_n += k;
+}
+
+static uint32_t load(const char *path, TouchTraceSample *s, uint32_t max, XPT_Map *map, int *crc_state){
+    FILE *f = fopen(path, "r");
+    *crc_state = CRC_NONE;
+    if(!f){ perror(path); return 0; }
+    char line[160];
+    uint32_t n = 0;
+    txt_n = 0;
+    while(fgets(line, sizeof(line), f) && n < max){
+        long xmin, xmax, ymin, ymax;
+        unsigned long crc;
+        const char *cal = strstr(line, "cal=");
+        if(line[0] == '#'){
+            if(cal && sscanf(cal, "cal=%ld,%ld,%ld,%ld", &xmin, &xmax, &ymin, &ymax) == 4){
+                map->x_min = xmin; map->x_max = xmax; map->y_min = ymin; map->y_max = ymax;
+            }
+            if(sscanf(line, "# crc32=%lx", &crc) == 1)
+                *crc_state = (Integrity_CRC32_SW(INTEGRITY_CRC32_INIT, txt, (uint32_t)txt_n) == crc)
+                             ? CRC_OK : CRC_BAD;
+            continue;
+        }
+        txt_add(line);
+        unsigned long t; unsigned fl, idx, x, y, z1, z2;
+        if(sscanf(line, "%lu,%u,%u,%u,%u,%u,%u", &t, &fl, &idx, &x, &y, &z1, &z2) != 7) continue;
+        s[n].t_us = (uint32_t)t; s[n].flags = (uint8_t)fl; s[n].idx = (uint8_t)idx;
+        s[n].x = (uint16_t)x; s[n].y = (uint16_t)y; s[n].z1 = (uint16_t)z1; s[n].z2 = (uint16_t)z2;
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+/* ====== Synthetic traces for the self-check ====== */
+typedef struct { TouchTraceSample s[4096]; uint32_t n, t; } Synth;
+
+static void syn_burst(Synth *y, uint16_t rx, uint16_t ry, int noise){
+    for(uint8_t i = 0; i < BURST_N; i++){
+        TouchTraceSample *p = &y->s[y->n++];
+        memset(p, 0, sizeof(*p));
+        p->t_us  = y->t; y->t += 40;               /* ~40 us per (Y,X) pair */
+        p->flags = (uint8_t)(TT_PEN_DOWN | (i == 0 ? TT_BURST_START : 0));
+        p->idx   = i;
+        p->x     = (uint16_t)(rx + ((i & 1) ? noise : -noise));
+        p->y     = (uint16_t)(ry + ((i & 1) ? -noise : noise));
+    }
+    y->t += 10000 - BURST_N * 40;                  /* 10 ms loop */
+}
+
+static void syn_up(Synth *y, uint32_t gap_us){
+    TouchTraceSample *p = &y->s[y->n++];
+    memset(p, 0, sizeof(*p));
+    p->t_us = y->t; y->t += gap_us;
+}
+
+static void syn_tap(Synth *y, uint16_t rx, uint16_t ry, int bursts, int noise, int drift){
+    for(int b = 0; b < bursts; b++) syn_burst(y, (uint16_t)(rx + b * drift), ry, noise);
+    syn_up(y, 400000);
+}
+
+static int check(const char *what, uint32_t got, uint32_t want){
+    if(got == want) return 0;
+    printf("FAIL %s: got %u, want %u\n", what, got, want);
+    return 1;
+}
+
+static int self_test(const XPT_Map *map){
+    static Synth y;
+    Report r;
+    int fail = 0;
+
+    /* clean taps at three spots + one drag: nothing misclassified */
+    memset(&y, 0, sizeof(y));
+    syn_tap(&y, 1000, 1000, 8, 3, 0);
+    syn_tap(&y, 2000, 2500, 5, 3, 0);
+    syn_tap(&y, 3000, 800, 12, 3, 0);
+    syn_tap(&y, 800, 2000, 60, 3, 40);            /* 600 ms drag, not a tap */
+    replay(y.s, y.n, map, &r);
+    print_report("synthetic: clean", &r);
+    fail |= check("clean strokes", r.strokes, 4);
+    fail |= check("clean taps", r.taps, 3);
+    fail |= check("clean misclassified", r.split + r.moved, 0);
+
+    /* one tap with a 20 ms contact bounce, one that slides off its button */
+    memset(&y, 0, sizeof(y));
+    for(int b = 0; b < 4; b++) syn_burst(&y, 1500, 1500, 2);
+    syn_up(&y, 20000);
+    syn_tap(&y, 1500, 1500, 3, 2, 0);
+    syn_tap(&y, 2000, 2000, 10, 2, 60);
+    replay(y.s, y.n, map, &r);
+    print_report("synthetic: bounce + slide", &r);
+    fail |= check("bounce split", r.split, 1);
+    fail |= check("slide moved", r.moved, 1);
+
+    printf(fail ? "touch_replay self-test FAILED\n" : "touch_replay self-test ok\n");
+    return fail;
+}
+
+int main(int argc, char **argv){
+    XPT_Map map = { 350, 3683, 350, 3802, SCREEN_W, SCREEN_H, SCREEN_ROT }; /* main.c defaults */
+    if(argc < 2) return self_test(&map);
+
+    static TouchTraceSample buf[MAX_SAMPLES];
+    for(int a = 1; a < argc; a++){
+        XPT_Map m = map;
+        int crc;
+        uint32_t n = load(argv[a], buf, MAX_SAMPLES, &m, &crc);
+        if(crc == CRC_BAD){ printf("%s: crc32 mismatch, capture damaged -- skipped\n", argv[a]); continue; }
+        if(crc == CRC_NONE) printf("%s: no crc32 line (truncated or v1 dump)\n", argv[a]);
+        Report r;
+        replay(buf, n, &m, &r);
+        print_report(argv[a], &r);
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/* Simulated endpoint layer, see usbfs_sim.h. */
+
+#include "usbfs_sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct { const uint8_t *p; uint32_t len; uint8_t armed; } SimIn;
+typedef struct { uint8_t *p; uint32_t len; uint8_t armed; } SimOut;
+
+static SimIn   in[3];
+static SimOut  out[3];
+static uint8_t stalled, address, configured, locked, inited;
+static uint32_t errors;
+
+static void err(const char *what){
+    printf("usbfs_sim: %s\n", what);
+    errors++;
+}
+
+/* ====== Endpoint layer (device side) ====== */
+void USBFS_Init(void){ inited = 1; }
+
+void USBFS_EpIn(uint8_t ep, const void *p, uint32_t len){
+    if(ep > 2){ err("EpIn: bad endpoint"); return; }
+    if(in[ep].armed) err("EpIn: endpoint already armed");
+    if(ep == USBFS_EP_BULK && len > USBFS_XFER_MAX) err("EpIn: transfer over USBFS_XFER_MAX");
+    if(len && !p) err("EpIn: NULL data");
+    in[ep].p = p; in[ep].len = len; in[ep].armed = 1;
+}
+
+void USBFS_EpOut(uint8_t ep, void *buf, uint32_t len){
+    if(ep > 2){ err("EpOut: bad endpoint"); return; }
+    out[ep].p = buf; out[ep].len = len; out[ep].armed = 1;
+}
+
+void USBFS_EpStall(uint8_t ep){
+    if(ep != 0) err("EpStall: only EP0 stalls");
+    stalled = 1;
+}
+
+void USBFS_SetAddress(uint8_t addr){ address = addr; }
+
+void USBFS_Configure(uint8_t on){
+    configured = on;
+    for(uint8_t ep = 1; ep < 3; ep++){ in[ep].armed = 0; out[ep].armed = 0; }
+}
+
+uint32_t USBFS_UniqueId(uint8_t word){ return 0x00300020u + word * 0x11111111u; }
+
+void USBFS_Lock(void){
+    if(locked) err("Lock: nested");
+    locked = 1;
+}
+
+void USBFS_Unlock(void){
+    if(!locked) err("Unlock: not locked");
+    locked = 0;
+}
+
+void USBFS_IRQHandler(void){ }
+
+/* ====== Host side ====== */
+static void irq_entry(void){
+    if(!inited) err("callback before USBFS_Init");
+    if(locked)  err("callback while USBFS_Lock is held");
+}
+
+void SimUSB_Reset(void){
+    memset(in, 0, sizeof(in));
+    memset(out, 0, sizeof(out));
+    stalled = 0; address = 0; configured = 0;
+    irq_entry();
+    USBFS_OnReset();
+}
+
+/* Collect an EP0 IN data stage (the class may arm a ZLP after it). */
+static int ep0_in(uint8_t *buf, uint16_t w_len){
+    uint32_t got = 0;
+    while(in[0].armed){
+        uint32_t n = in[0].len;
+        if(got + n > w_len){ err("EP0 IN: more than wLength"); n = w_len - got; }
+        if(buf && n) memcpy(buf + got, in[0].p, n);
+        got += n;
+        in[0].armed = 0;
+        irq_entry();
+        USBFS_OnInDone(0);
+    }
+    return (int)got;
+}
+
+int SimUSB_Control(uint8_t bm, uint8_t req, uint16_t val, uint16_t idx,
+                   uint16_t len, const void *data, uint8_t *buf){
+    uint8_t s[8] = { bm, req, (uint8_t)val, (uint8_t)(val >> 8),
+                     (uint8_t)idx, (uint8_t)(idx >> 8), (uint8_t)len, (uint8_t)(len >> 8) };
+    stalled = 0;
+    out[0].armed = 0;
+    irq_entry();
+    USBFS_OnSetup(s);
+    if(stalled) return -1;
+
+    if((bm & 0x80u) && len){                    /* IN data stage, then OUT status */
+        int n = ep0_in(buf, len);
+        return stalled ? -1 : n;
+    }
+    if(len){                                    /* OUT data stage */
+        if(!out[0].armed){ err("EP0 OUT data stage not armed"); return -1; }
+        uint32_t n = len < out[0].len ? len : out[0].len;
+        memcpy(out[0].p, data, n);
+        out[0].armed = 0;
+        irq_entry();
+        USBFS_OnOutDone(0, n);
+    }
+    if(!in[0].armed){ err("no status stage"); return -1; }
+    if(in[0].len){ err("status stage with data"); return -1; }
+    ep0_in(NULL, 0);
+    return stalled ? -1 : 0;
+}
+
+uint8_t SimUSB_ReadOne(SimCapture *cap){
+    SimIn *e = &in[USBFS_EP_BULK];
+    if(!e->armed) return 0;
+    if(cap->n + e->len > SIM_CAP) err("capture full");
+    else { if(e->len) memcpy(cap->data + cap->n, e->p, e->len); cap->n += e->len; }
+    if(cap->xfers < 256u) cap->xfer_len[cap->xfers] = e->len;
+    cap->xfers++;
+    e->armed = 0;
+    irq_entry();
+    USBFS_OnInDone(USBFS_EP_BULK);
+    return 1;
+}
+
+uint32_t SimUSB_Drain(SimCapture *cap){
+    uint32_t n0 = cap->n;
+    while(SimUSB_ReadOne(cap)) { }
+    return cap->n - n0;
+}
+
+uint8_t SimUSB_Write(const void *p, uint32_t len){
+    SimOut *e = &out[USBFS_EP_BULK];
+    if(!e->armed) return 0;
+    if(len > e->len) len = e->len;
+    memcpy(e->p, p, len);
+    e->armed = 0;
+    irq_entry();
+    USBFS_OnOutDone(USBFS_EP_BULK, len);
+    return 1;
+}
+
+uint8_t  SimUSB_InArmed(uint8_t ep){ return ep < 3 ? in[ep].armed : 0; }
+uint8_t  SimUSB_Address(void){ return address; }
+uint8_t  SimUSB_Configured(void){ return configured; }
+uint32_t SimUSB_Errors(void){ return errors; }
@@ -0,0 +1,48 @@
+#ifndef USBFS_SIM_H
+#define USBFS_SIM_H
+
+/* Simulated endpoint layer (usb_fs.h) for running the CDC class code
+ * (usb_cdc.c) on the host.
+ *
+ * The USBFS_* functions record what the class arms; the SimUSB_* calls
+ * play the host side and run the USBFS_On* callbacks the way the OTG
+ * interrupt would -- never while the class holds USBFS_Lock(). IN data is
+ * copied out of the class's memory only when the host reads it, as the
+ * FIFO refill does on target, so a buffer reused too early shows up as
+ * wrong bytes. Protocol slips (an endpoint armed twice, a callback under
+ * the lock, an oversized transfer) are counted in SimUSB_Errors(). */
+
+#include "usb_fs.h"
+
+#include <stdint.h>
+
+#define SIM_CAP  65536u                 /* bytes captured per direction */
+
+typedef struct {
+    uint8_t  data[SIM_CAP];
+    uint32_t n;                         /* bytes captured               */
+    uint32_t xfer_len[256];             /* length of each IN transfer   */
+    uint32_t xfers;
+} SimCapture;
+
+void     SimUSB_Reset(void);            /* bus reset: USBFS_OnReset()   */
+
+/* Control transfer. IN data stage: returns bytes received into `in`
+   (up to wLength), or -1 on a stall. OUT data stage: `out` / wLength are
+   sent after the SETUP; returns 0 or -1. */
+int      SimUSB_Control(uint8_t bm, uint8_t req, uint16_t val, uint16_t idx,
+                        uint16_t len, const void *out, uint8_t *in);
+
+/* Host reads EP1 IN until the device has nothing armed; returns bytes. */
+uint32_t SimUSB_Drain(SimCapture *cap);
+/* Complete one EP1 IN transfer, if armed; returns 1 if one ran. */
+uint8_t  SimUSB_ReadOne(SimCapture *cap);
+/* Host writes one EP1 OUT packet; returns 0 if EP1 OUT was not armed. */
+uint8_t  SimUSB_Write(const void *p, uint32_t len);
+
+uint8_t  SimUSB_InArmed(uint8_t ep);
+uint8_t  SimUSB_Address(void);
+uint8_t  SimUSB_Configured(void);
+uint32_t SimUSB_Errors(void);
+
+#endif /* USBFS_SIM_H */